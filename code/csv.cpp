@@ -0,0 +1,1599 @@
+#ifndef CSV_C
+#define CSV_C
+
+#if defined(_WIN32)
+static void*
+csv_alloc(u64 size){
+    void* result = VirtualAlloc(0, size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+    return(result);
+}
+
+static void
+csv_free(void* memory, u64 size){
+    VirtualFree(memory, 0, MEM_RELEASE);
+}
+
+static MappedFile
+os_open_mapping(String8 path){
+    MappedFile result = {0};
+
+    result.file = os_file_open(path, GENERIC_READ, OPEN_EXISTING);
+    if(result.file.handle == INVALID_HANDLE_VALUE || !result.file.size){
+        return(result);
+    }
+
+    // note: size 0/0 maps the whole file, empty files can't be mapped which is why we check size above
+    result.mapping = CreateFileMappingA(result.file.handle, 0, PAGE_READONLY, 0, 0, 0);
+    if(!result.mapping){
+        print("Error: CreateFileMapping failed <%s> (%lu)\n", path.str, GetLastError());
+        return(result);
+    }
+
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    result.granularity = info.dwAllocationGranularity;
+    return(result);
+}
+
+// note: Maps [offset, offset + size) replacing the previous view. Views have to start on the allocation
+// granularity so we map from the aligned offset and hand back a view starting at offset.
+static String8
+os_map_view(MappedFile* mapped, u64 offset, u64 size){
+    if(mapped->view){
+        UnmapViewOfFile(mapped->view);
+        mapped->view = 0;
+        mapped->data = {0};
+    }
+    if(!mapped->mapping || offset >= mapped->file.size){
+        return(mapped->data);
+    }
+    if(size > mapped->file.size - offset){
+        size = mapped->file.size - offset;
+    }
+
+    u64 aligned = offset & ~((u64)mapped->granularity - 1);
+    u64 lead = offset - aligned;
+    mapped->view = (u8*)MapViewOfFile(mapped->mapping, FILE_MAP_READ, (DWORD)(aligned >> 32), (DWORD)(aligned & 0xFFFFFFFF), lead + size);
+    if(!mapped->view){
+        print("Error: MapViewOfFile failed (%lu)\n", GetLastError());
+        return(mapped->data);
+    }
+
+    mapped->data = {mapped->view + lead, size};
+    return(mapped->data);
+}
+
+static void
+os_close_mapping(MappedFile* mapped){
+    if(mapped->view){
+        UnmapViewOfFile(mapped->view);
+    }
+    if(mapped->mapping){
+        CloseHandle(mapped->mapping);
+    }
+    os_file_close(mapped->file);
+    *mapped = {0};
+}
+
+static u32
+csv_processor_count(void){
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return(info.dwNumberOfProcessors);
+}
+
+static DWORD WINAPI
+csv_worker_proc(LPVOID param){
+    CSVChunk* chunk = (CSVChunk*)param;
+    chunk->work(chunk);
+    return(0);
+}
+
+static void
+csv_thread_start(CSVChunk* chunk){
+    chunk->thread = CreateThread(0, 0, csv_worker_proc, chunk, 0, 0);
+}
+
+static void
+csv_thread_join(CSVChunk* chunk){
+    WaitForSingleObject(chunk->thread, INFINITE);
+    CloseHandle(chunk->thread);
+    chunk->thread = 0;
+}
+#else
+static void*
+csv_alloc(u64 size){
+    void* result = mmap(0, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    return(result == MAP_FAILED ? 0 : result);
+}
+
+static void
+csv_free(void* memory, u64 size){
+    munmap(memory, size);
+}
+
+static MappedFile
+os_open_mapping(String8 path){
+    MappedFile result = {};
+    result.file.handle = open((char*)path.str, O_RDONLY);
+    if(result.file.handle < 0){
+        return(result);
+    }
+    struct stat info;
+    if(fstat(result.file.handle, &info) != 0 || !info.st_size){
+        return(result);
+    }
+    result.file.size = (u64)info.st_size;
+    result.mapping = true;
+    result.granularity = (u32)sysconf(_SC_PAGESIZE);
+    return(result);
+}
+
+static String8
+os_map_view(MappedFile* mapped, u64 offset, u64 size){
+    if(mapped->view){
+        munmap(mapped->view, mapped->view_size);
+        mapped->view = 0;
+        mapped->data = {0};
+    }
+    if(!mapped->mapping || offset >= mapped->file.size){
+        return(mapped->data);
+    }
+    if(size > mapped->file.size - offset){
+        size = mapped->file.size - offset;
+    }
+
+    u64 aligned = offset & ~((u64)mapped->granularity - 1);
+    u64 lead = offset - aligned;
+    void* view = mmap(0, lead + size, PROT_READ, MAP_PRIVATE, mapped->file.handle, (off_t)aligned);
+    if(view == MAP_FAILED){
+        print("Error: mmap failed (%d)\n", errno);
+        return(mapped->data);
+    }
+    madvise(view, lead + size, MADV_SEQUENTIAL);
+
+    mapped->view = (u8*)view;
+    mapped->view_size = lead + size;
+    mapped->data = {mapped->view + lead, size};
+    return(mapped->data);
+}
+
+static void
+os_close_mapping(MappedFile* mapped){
+    if(mapped->view){
+        munmap(mapped->view, mapped->view_size);
+    }
+    if(mapped->file.handle >= 0){
+        close(mapped->file.handle);
+    }
+    *mapped = {};
+}
+
+static u32
+csv_processor_count(void){
+    return((u32)sysconf(_SC_NPROCESSORS_ONLN));
+}
+
+static void*
+csv_worker_proc(void* param){
+    CSVChunk* chunk = (CSVChunk*)param;
+    chunk->work(chunk);
+    return(0);
+}
+
+static void
+csv_thread_start(CSVChunk* chunk){
+    pthread_create(&chunk->thread, 0, csv_worker_proc, chunk);
+}
+
+static void
+csv_thread_join(CSVChunk* chunk){
+    pthread_join(chunk->thread, 0);
+    chunk->thread = {};
+}
+#endif
+
+// note: fields are views into the mapped window, this is the only place their bytes get written anywhere.
+// Clamps to the destination so a long description can't run past the transactions fixed buffers.
+static void
+csv_copy_field(char* dst, u32 capacity, String8 field){
+    while(field.size && (field.str[field.size - 1] == '\n' || field.str[field.size - 1] == '\r' || field.str[field.size - 1] == '\x1B')){
+        --field.size;
+    }
+
+    u64 size = field.size < capacity ? field.size : capacity - 1;
+    // note: don't cut a utf-8 sequence in half
+    while(size && size < field.size && (field.str[size] & 0xC0) == 0x80){
+        --size;
+    }
+    memcpy(dst, field.str, size);
+    dst[size] = '\0';
+}
+
+static bool
+cpu_has_avx2(void){
+#if COMPILER_CL
+    s32 info[4];
+    __cpuid(info, 0);
+    if(info[0] < 7){
+        return(false);
+    }
+
+    // note: the OS has to save the ymm registers too, not just the cpu supporting it
+    __cpuid(info, 1);
+    bool osxsave = info[2] & (1 << 27);
+    bool avx = info[2] & (1 << 28);
+    if(!osxsave || !avx || (_xgetbv(0) & 6) != 6){
+        return(false);
+    }
+
+    __cpuidex(info, 7, 0);
+    return((info[1] & (1 << 5)) != 0);
+#else
+    return(__builtin_cpu_supports("avx2"));
+#endif
+}
+
+static u64
+csv_lowest_bit(u64 value){
+#if COMPILER_CL
+    unsigned long idx;
+    _BitScanForward64(&idx, value);
+    return(idx);
+#else
+    return((u64)__builtin_ctzll(value));
+#endif
+}
+
+// note: bit i ends up as the xor of bits 0..i, so every bit between an opening and closing quote is set.
+// Doubled quotes ("") flip it twice which is exactly what we want.
+static u64
+csv_prefix_xor(u64 value){
+    value ^= value << 1;
+    value ^= value << 2;
+    value ^= value << 4;
+    value ^= value << 8;
+    value ^= value << 16;
+    value ^= value << 32;
+    return(value);
+}
+
+// note: used for the last partial block, size < 64
+static CSVBlock
+csv_classify_block_scalar(u8* ptr, u64 size, u8 delimiter, u8 quote){
+    CSVBlock result = {0};
+    for(u64 i=0; i < size; ++i){
+        u8 c = ptr[i];
+        u64 bit = (u64)1 << i;
+        if(c == delimiter){
+            result.delimiters |= bit;
+        }
+        if(quote && c == quote){
+            result.quotes |= bit;
+        }
+        if(c == '\n' || c == '\r'){
+            result.newlines |= bit;
+        }
+    }
+    return(result);
+}
+
+static CSVBlock
+csv_classify_block_sse2(u8* ptr, u8 delimiter, u8 quote){
+    CSVBlock result = {0};
+    __m128i d  = _mm_set1_epi8((char)delimiter);
+    __m128i q  = _mm_set1_epi8((char)quote);
+    __m128i cr = _mm_set1_epi8('\r');
+    __m128i lf = _mm_set1_epi8('\n');
+
+    for(u32 i=0; i < 4; ++i){
+        __m128i v = _mm_loadu_si128((__m128i*)(ptr + i*16));
+        u64 delimiters = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(v, d));
+        u64 quotes     = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(v, q));
+        u64 newlines   = (u32)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, lf)));
+
+        result.delimiters |= delimiters << (i*16);
+        result.quotes     |= quotes << (i*16);
+        result.newlines   |= newlines << (i*16);
+    }
+    if(!quote){
+        result.quotes = 0;
+    }
+    return(result);
+}
+
+CSV_TARGET_AVX2 static CSVBlock
+csv_classify_block_avx2(u8* ptr, u8 delimiter, u8 quote){
+    CSVBlock result = {0};
+    __m256i d  = _mm256_set1_epi8((char)delimiter);
+    __m256i q  = _mm256_set1_epi8((char)quote);
+    __m256i cr = _mm256_set1_epi8('\r');
+    __m256i lf = _mm256_set1_epi8('\n');
+
+    for(u32 i=0; i < 2; ++i){
+        __m256i v = _mm256_loadu_si256((__m256i*)(ptr + i*32));
+        u64 delimiters = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, d));
+        u64 quotes     = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, q));
+        u64 newlines   = (u32)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, cr), _mm256_cmpeq_epi8(v, lf)));
+
+        result.delimiters |= delimiters << (i*32);
+        result.quotes     |= quotes << (i*32);
+        result.newlines   |= newlines << (i*32);
+    }
+    if(!quote){
+        result.quotes = 0;
+    }
+    return(result);
+}
+
+static u64
+csv_popcount(u64 value){
+#if COMPILER_CL
+    return(__popcnt64(value));
+#else
+    return((u64)__builtin_popcountll(value));
+#endif
+}
+
+static CSVBlock
+csv_classify_block(u8* ptr, u64 size, u8 delimiter, u8 quote, bool avx2){
+    CSVBlock result;
+    if(size < 64){
+        result = csv_classify_block_scalar(ptr, size, delimiter, quote);
+    }
+    else if(avx2){
+        result = csv_classify_block_avx2(ptr, delimiter, quote);
+    }
+    else{
+        result = csv_classify_block_sse2(ptr, delimiter, quote);
+    }
+    return(result);
+}
+
+static bool
+csv_use_avx2(void){
+    static s32 has_avx2 = -1;
+    if(has_avx2 == -1){
+        has_avx2 = cpu_has_avx2();
+    }
+    return(has_avx2);
+}
+
+static CSVScanner
+csv_scanner(String8 data, u8 delimiter, u8 quote){
+    CSVScanner result = {0};
+    result.data = data;
+    result.delimiter = delimiter;
+    result.quote = quote;
+    result.avx2 = csv_use_avx2();
+
+    // note: newline wins if the delimiter is a newline (line splitting)
+    result.classes[delimiter] = CSVClass_Delimiter;
+    if(quote){
+        result.classes[quote] = CSVClass_Quote;
+    }
+    result.classes['\r'] = CSVClass_Newline;
+    result.classes['\n'] = CSVClass_Newline;
+    return(result);
+}
+
+static bool
+csv_next_structural(CSVScanner* scanner, u64* idx){
+    while(!scanner->structurals){
+        if(scanner->block_at >= scanner->data.size){
+            return(false);
+        }
+
+        u8* ptr = scanner->data.str + scanner->block_at;
+        CSVBlock block = csv_classify_block(ptr, scanner->data.size - scanner->block_at, scanner->delimiter, scanner->quote, scanner->avx2);
+
+        u64 in_quote = csv_prefix_xor(block.quotes) ^ scanner->quote_carry;
+        scanner->quote_carry = (u64)((s64)in_quote >> 63);
+        scanner->structurals = (block.delimiters | block.newlines) & ~in_quote;
+        scanner->block_base = scanner->block_at;
+        scanner->block_at += 64;
+    }
+
+    *idx = scanner->block_base + csv_lowest_bit(scanner->structurals);
+    scanner->structurals &= scanner->structurals - 1;
+    return(true);
+}
+
+// note: Transition table for RFC 4180 fields. Each entry packs the next state (low nibble) and the action
+// to take (high nibble). Ordinary bytes never reach the table one at a time: csv_next_field only visits
+// delimiters, quotes and newlines, and applies the Other column once for each run of ordinary bytes
+// in between.
+#define CSV_STEP(state, action) (u8)((CSVState_##state) | ((CSVAction_##action) << 4))
+static u8 csv_transitions[CSVState_Count][CSVClass_Count] = {
+    //                    Other                    Delimiter                Quote                         Newline
+    /* FieldStart */    { CSV_STEP(Unquoted, None), CSV_STEP(FieldStart, Field), CSV_STEP(Quoted, Open),        CSV_STEP(FieldStart, Record) },
+    /* Unquoted */      { CSV_STEP(Unquoted, None), CSV_STEP(FieldStart, Field), CSV_STEP(Unquoted, None),      CSV_STEP(FieldStart, Record) },
+    /* Quoted */        { CSV_STEP(Quoted, None),   CSV_STEP(Quoted, None),      CSV_STEP(QuoteInQuoted, Quote), CSV_STEP(Quoted, None) },
+    /* QuoteInQuoted */ { CSV_STEP(Unquoted, None), CSV_STEP(FieldStart, Field), CSV_STEP(Quoted, Escape),      CSV_STEP(FieldStart, Record) },
+};
+#undef CSV_STEP
+
+static void
+csv_emit_field(CSVScanner* scanner, CSVField* field, u64 end, bool end_of_record){
+    if(scanner->quoted){
+        u64 content_end = scanner->state == CSVState_Quoted ? end : scanner->content_end;
+        field->text = {scanner->data.str + scanner->content_start, content_end - scanner->content_start};
+    }
+    else{
+        field->text = {scanner->data.str + scanner->field_start, end - scanner->field_start};
+    }
+    field->escaped = scanner->escaped;
+    field->end_of_record = end_of_record;
+
+    scanner->field_start = end + 1;
+    scanner->in_record = !end_of_record;
+    scanner->quoted = false;
+    scanner->escaped = false;
+}
+
+// note: Returns the next field in one pass. Quoted fields come back without their outer quotes as a view
+// into data, only fields containing doubled quotes ("") have field->escaped set and need csv_unescape.
+// '\r' and '\n' both end a record, so "\r\n" shows up as an extra empty record that callers skip.
+static bool
+csv_next_field(CSVScanner* scanner, CSVField* field){
+    if(scanner->field_start > scanner->data.size){
+        return(false);
+    }
+
+    for(;;){
+        while(!scanner->specials){
+            if(scanner->block_at >= scanner->data.size){
+                // note: last field without a trailing newline
+                if(scanner->field_start < scanner->data.size || scanner->state != CSVState_FieldStart || scanner->in_record){
+                    csv_emit_field(scanner, field, scanner->data.size, true);
+                    scanner->state = CSVState_FieldStart;
+                    return(true);
+                }
+                scanner->field_start = scanner->data.size + 1;
+                return(false);
+            }
+
+            u8* ptr = scanner->data.str + scanner->block_at;
+            CSVBlock block = csv_classify_block(ptr, scanner->data.size - scanner->block_at, scanner->delimiter, scanner->quote, scanner->avx2);
+            scanner->specials = block.delimiters | block.quotes | block.newlines;
+            scanner->specials_base = scanner->block_at;
+            scanner->block_at += 64;
+        }
+
+        u64 idx = scanner->specials_base + csv_lowest_bit(scanner->specials);
+        scanner->specials &= scanner->specials - 1;
+
+        u8 state = scanner->state;
+        state = idx > scanner->at ? (csv_transitions[state][CSVClass_Other] & 0xF) : state;
+        u8 step = csv_transitions[state][scanner->classes[scanner->data.str[idx]]];
+        scanner->state = step & 0xF;
+        scanner->at = idx + 1;
+
+        switch(step >> 4){
+            case CSVAction_Open:{
+                scanner->quoted = true;
+                scanner->content_start = idx + 1;
+            } break;
+            case CSVAction_Quote:{
+                scanner->content_end = idx;
+            } break;
+            case CSVAction_Escape:{
+                scanner->escaped = true;
+            } break;
+            case CSVAction_Field:{
+                csv_emit_field(scanner, field, idx, false);
+                return(true);
+            } break;
+            case CSVAction_Record:{
+                csv_emit_field(scanner, field, idx, true);
+                return(true);
+            } break;
+        }
+    }
+}
+
+// note: collapses "" into ", only ever called for fields the scanner flagged as escaped
+static String8
+csv_unescape(Arena* arena, String8 text, u8 quote){
+    u8* dst = push_array(arena, u8, text.size);
+    u64 size = 0;
+    for(u64 i=0; i < text.size; ++i){
+        dst[size++] = text.str[i];
+        if(text.str[i] == quote && i + 1 < text.size && text.str[i + 1] == quote){
+            ++i;
+        }
+    }
+
+    String8 result = {dst, size};
+    return(result);
+}
+
+// note: BOMs decide it, otherwise the first KB is sampled. Zero bytes in every other position are
+// utf-16 without a BOM, bytes that aren't valid utf-8 are taken to be windows-1252.
+static CSVEncoding
+csv_detect_encoding(String8 data, u64* bom_size){
+    *bom_size = 0;
+    if(data.size >= 3 && data.str[0] == 0xEF && data.str[1] == 0xBB && data.str[2] == 0xBF){
+        *bom_size = 3;
+        return(CSVEncoding_UTF8);
+    }
+    if(data.size >= 2 && data.str[0] == 0xFF && data.str[1] == 0xFE){
+        *bom_size = 2;
+        return(CSVEncoding_UTF16LE);
+    }
+    if(data.size >= 2 && data.str[0] == 0xFE && data.str[1] == 0xFF){
+        *bom_size = 2;
+        return(CSVEncoding_UTF16BE);
+    }
+
+    u64 size = data.size < KB(1) ? data.size : KB(1);
+    u64 even_zeros = 0;
+    u64 odd_zeros = 0;
+    for(u64 i=0; i + 1 < size; i += 2){
+        even_zeros += !data.str[i];
+        odd_zeros += !data.str[i + 1];
+    }
+    if(odd_zeros > size / 8 && odd_zeros > even_zeros * 4){
+        return(CSVEncoding_UTF16LE);
+    }
+    if(even_zeros > size / 8 && even_zeros > odd_zeros * 4){
+        return(CSVEncoding_UTF16BE);
+    }
+
+    for(u64 i=0; i < size;){
+        u8 c = data.str[i];
+        u64 length = (c < 0x80) ? 1 : ((c & 0xE0) == 0xC0) ? 2 : ((c & 0xF0) == 0xE0) ? 3 : ((c & 0xF8) == 0xF0) ? 4 : 0;
+        if(!length || (length == 2 && c < 0xC2)){
+            return(CSVEncoding_Windows1252);
+        }
+        // note: a sequence cut by the end of the sample is fine
+        if(i + length > size){
+            break;
+        }
+        for(u64 j=1; j < length; ++j){
+            if((data.str[i + j] & 0xC0) != 0x80){
+                return(CSVEncoding_Windows1252);
+            }
+        }
+        i += length;
+    }
+    return(CSVEncoding_UTF8);
+}
+
+// note: 0x80-0x9F of windows-1252, the rest of the upper half is latin-1
+static u16 windows1252_high[32] = {
+    0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, 0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008D, 0x017D, 0x008F,
+    0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, 0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178,
+};
+
+static u64
+csv_utf8_encode(u32 codepoint, u8* dst){
+    if(codepoint < 0x80){
+        if(dst){
+            dst[0] = (u8)codepoint;
+        }
+        return(1);
+    }
+    if(codepoint < 0x800){
+        if(dst){
+            dst[0] = (u8)(0xC0 | (codepoint >> 6));
+            dst[1] = (u8)(0x80 | (codepoint & 0x3F));
+        }
+        return(2);
+    }
+    if(codepoint < 0x10000){
+        if(dst){
+            dst[0] = (u8)(0xE0 | (codepoint >> 12));
+            dst[1] = (u8)(0x80 | ((codepoint >> 6) & 0x3F));
+            dst[2] = (u8)(0x80 | (codepoint & 0x3F));
+        }
+        return(3);
+    }
+    if(dst){
+        dst[0] = (u8)(0xF0 | (codepoint >> 18));
+        dst[1] = (u8)(0x80 | ((codepoint >> 12) & 0x3F));
+        dst[2] = (u8)(0x80 | ((codepoint >> 6) & 0x3F));
+        dst[3] = (u8)(0x80 | (codepoint & 0x3F));
+    }
+    return(4);
+}
+
+// note: Transcodes src to utf-8 into dst, at most dst_limit bytes, and returns the size written. With dst 0
+// it only counts, which is how an offset in the output is turned back into an offset in the source.
+// Runs of ascii go 16 bytes of output at a time, everything else goes a character at a time. src_used is
+// how much of src was turned into output, a utf-16 unit or surrogate pair cut by the end of src is left.
+static u64
+csv_transcode(CSVEncoding encoding, String8 src, u8* dst, u64 dst_limit, u64* src_used){
+    u64 in = 0;
+    u64 out = 0;
+    if(encoding == CSVEncoding_Windows1252){
+        while(in < src.size){
+            if(in + 16 <= src.size && out + 16 <= dst_limit){
+                __m128i v = _mm_loadu_si128((__m128i*)(src.str + in));
+                if(!_mm_movemask_epi8(v)){
+                    if(dst){
+                        _mm_storeu_si128((__m128i*)(dst + out), v);
+                    }
+                    in += 16;
+                    out += 16;
+                    continue;
+                }
+            }
+
+            u8 c = src.str[in];
+            u32 codepoint = (c >= 0x80 && c < 0xA0) ? windows1252_high[c - 0x80] : c;
+            u64 length = csv_utf8_encode(codepoint, 0);
+            if(out + length > dst_limit){
+                break;
+            }
+            if(dst){
+                csv_utf8_encode(codepoint, dst + out);
+            }
+            out += length;
+            in += 1;
+        }
+    }
+    else if(encoding == CSVEncoding_UTF16LE || encoding == CSVEncoding_UTF16BE){
+        bool big_endian = (encoding == CSVEncoding_UTF16BE);
+        while(in + 2 <= src.size){
+            // note: 8 units that are all ascii pack down to 8 bytes, two loads make 16
+            if(in + 32 <= src.size && out + 16 <= dst_limit){
+                __m128i a = _mm_loadu_si128((__m128i*)(src.str + in));
+                __m128i b = _mm_loadu_si128((__m128i*)(src.str + in + 16));
+                if(big_endian){
+                    a = _mm_or_si128(_mm_slli_epi16(a, 8), _mm_srli_epi16(a, 8));
+                    b = _mm_or_si128(_mm_slli_epi16(b, 8), _mm_srli_epi16(b, 8));
+                }
+                __m128i high = _mm_and_si128(_mm_or_si128(a, b), _mm_set1_epi16((s16)0xFF80));
+                if(_mm_movemask_epi8(_mm_cmpeq_epi16(high, _mm_setzero_si128())) == 0xFFFF){
+                    if(dst){
+                        _mm_storeu_si128((__m128i*)(dst + out), _mm_packus_epi16(a, b));
+                    }
+                    in += 32;
+                    out += 16;
+                    continue;
+                }
+            }
+
+            u32 unit = big_endian ? ((u32)src.str[in] << 8) | src.str[in + 1] : ((u32)src.str[in + 1] << 8) | src.str[in];
+            u64 unit_size = 2;
+            u32 codepoint = unit;
+            if(unit >= 0xD800 && unit < 0xDC00){
+                if(in + 4 > src.size){
+                    break;
+                }
+                u32 low = big_endian ? ((u32)src.str[in + 2] << 8) | src.str[in + 3] : ((u32)src.str[in + 3] << 8) | src.str[in + 2];
+                if(low >= 0xDC00 && low < 0xE000){
+                    codepoint = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                    unit_size = 4;
+                }
+                else{
+                    codepoint = 0xFFFD;
+                }
+            }
+            else if(unit >= 0xDC00 && unit < 0xE000){
+                codepoint = 0xFFFD;
+            }
+
+            u64 length = csv_utf8_encode(codepoint, 0);
+            if(out + length > dst_limit){
+                break;
+            }
+            if(dst){
+                csv_utf8_encode(codepoint, dst + out);
+            }
+            out += length;
+            in += unit_size;
+        }
+    }
+    else{
+        in = src.size < dst_limit ? src.size : dst_limit;
+        if(dst){
+            memcpy(dst, src.str, in);
+        }
+        out = in;
+    }
+
+    *src_used = in;
+    return(out);
+}
+
+static CSVReader
+csv_reader(MappedFile* mapped, u64* data_start){
+    CSVReader result = {0};
+    result.mapped = mapped;
+    String8 head = os_map_view(mapped, 0, KB(4));
+    result.encoding = csv_detect_encoding(head, data_start);
+    return(result);
+}
+
+// note: window of about size bytes of utf-8 starting at source offset, final if it reaches the end of the file
+static String8
+csv_reader_window(CSVReader* reader, u64 offset, u64 size, bool* final){
+    MappedFile* mapped = reader->mapped;
+    if(reader->encoding == CSVEncoding_UTF8){
+        reader->raw = os_map_view(mapped, offset, size);
+        *final = (offset + reader->raw.size == mapped->file.size);
+        return(reader->raw);
+    }
+
+    // note: a source byte is at most 3 bytes of utf-8 (1.5 per byte for utf-16), map less so the output is about size
+    u64 expansion = (reader->encoding == CSVEncoding_Windows1252) ? 3 : 2;
+    u64 raw_size = size / expansion;
+    raw_size = raw_size < 4 ? 4 : raw_size;
+    reader->raw = os_map_view(mapped, offset, raw_size);
+
+    u64 buffer_size = reader->raw.size * 3 + 16;
+    if(buffer_size > reader->buffer_size){
+        if(reader->buffer){
+            csv_free(reader->buffer, reader->buffer_size);
+        }
+        reader->buffer = (u8*)csv_alloc(buffer_size);
+        reader->buffer_size = buffer_size;
+    }
+
+    u64 src_used = 0;
+    u64 out = csv_transcode(reader->encoding, reader->raw, reader->buffer, reader->buffer_size, &src_used);
+    // note: a dangling byte or half a surrogate pair at the end of the file isn't a character, it's dropped
+    *final = (offset + reader->raw.size == mapped->file.size);
+
+    String8 result = {reader->buffer, out};
+    return(result);
+}
+
+// note: how many source bytes the first size bytes of the current window came from
+static u64
+csv_reader_source_size(CSVReader* reader, u64 size){
+    if(reader->encoding == CSVEncoding_UTF8){
+        return(size);
+    }
+    u64 src_used = 0;
+    csv_transcode(reader->encoding, reader->raw, 0, size, &src_used);
+    return(src_used);
+}
+
+static void
+csv_reader_release(CSVReader* reader){
+    if(reader->buffer){
+        csv_free(reader->buffer, reader->buffer_size);
+    }
+    *reader = {0};
+}
+
+// note: accepts M/D/Y (what the app writes), Y-M-D, and D/M/Y when the first part can't be a month or
+// the dialect is day first (unless the second part can't be a month). '/', '-' and '.' all work as
+// separators, two digit years are 20YY, anything after the day (a time) is ignored.
+static u32
+csv_parse_date(String8 text, bool day_first){
+    u32 parts[3] = {0};
+    u32 digits[3] = {0};
+    u32 part = 0;
+    for(u64 i=0; i < text.size && part < 3; ++i){
+        u8 c = text.str[i];
+        if(c >= '0' && c <= '9'){
+            parts[part] = parts[part] * 10 + (c - '0');
+            ++digits[part];
+        }
+        else if((c == '/' || c == '-' || c == '.') && digits[part] && part < 2){
+            ++part;
+        }
+        else if(digits[part]){
+            break;
+        }
+    }
+    if(!digits[0] || !digits[1] || !digits[2] || digits[0] > 4 || digits[1] > 2 || digits[2] > 4){
+        return(0);
+    }
+
+    u32 year, month, day;
+    if(digits[0] > 2){
+        year = parts[0]; month = parts[1]; day = parts[2];
+    }
+    else if(parts[0] > 12 || (day_first && parts[1] <= 12)){
+        day = parts[0]; month = parts[1]; year = parts[2];
+    }
+    else{
+        month = parts[0]; day = parts[1]; year = parts[2];
+    }
+    if(digits[0] <= 2 && digits[2] <= 2){
+        year += 2000;
+    }
+    if(month < 1 || month > 12 || day < 1 || day > 31 || year > 0x7FFFFF){
+        return(0);
+    }
+
+    u32 result = date_key(year, month, day);
+    return(result);
+}
+
+// note: 16 ascii digits to an integer with SSE2. Digits are widened to u16 and neighbouring lanes are
+// multiply-added, (10,1) gives 2 digit lanes, (100,1) 4 digit lanes, (10000,1) 8 digit lanes.
+static u64
+csv_digits16(u8* digits){
+    __m128i zero = _mm_setzero_si128();
+    __m128i v = _mm_sub_epi8(_mm_loadu_si128((__m128i*)digits), _mm_set1_epi8('0'));
+
+    __m128i pairs_lo = _mm_madd_epi16(_mm_unpacklo_epi8(v, zero), _mm_set_epi16(1, 10, 1, 10, 1, 10, 1, 10));
+    __m128i pairs_hi = _mm_madd_epi16(_mm_unpackhi_epi8(v, zero), _mm_set_epi16(1, 10, 1, 10, 1, 10, 1, 10));
+    __m128i pairs = _mm_packs_epi32(pairs_lo, pairs_hi);
+
+    __m128i quads = _mm_madd_epi16(pairs, _mm_set_epi16(1, 100, 1, 100, 1, 100, 1, 100));
+    quads = _mm_packs_epi32(quads, quads);
+
+    __m128i octs = _mm_madd_epi16(quads, _mm_set_epi16(1, 10000, 1, 10000, 1, 10000, 1, 10000));
+    u64 high = (u32)_mm_cvtsi128_si32(octs);
+    u64 low = (u32)_mm_cvtsi128_si32(_mm_srli_si128(octs, 4));
+
+    u64 result = high * 100000000 + low;
+    return(result);
+}
+
+// note: amount text to cents. '-' or '(' make it negative, digits past the cents are dropped, anything that
+// isn't a digit, sign or the decimal separator (thousands separators, currency, spaces) is skipped.
+// More than 16 digits doesn't fit the digit lanes and parses as 0.
+static s64
+csv_parse_amount(String8 text, u8 decimal){
+    u8 buffer[16];
+    u32 count = 0;
+    u32 fraction = 0;
+    bool in_fraction = false;
+    bool negative = false;
+
+    for(u64 i=0; i < text.size; ++i){
+        u8 c = text.str[i];
+        if(c >= '0' && c <= '9'){
+            if(in_fraction){
+                if(fraction == 2){
+                    continue;
+                }
+                ++fraction;
+            }
+            if(count == array_count(buffer)){
+                return(0);
+            }
+            buffer[count++] = c;
+        }
+        else if(c == decimal){
+            in_fraction = true;
+        }
+        else if(c == '-' || c == '('){
+            negative = true;
+        }
+    }
+    if(!count){
+        return(0);
+    }
+    for(; fraction < 2; ++fraction){
+        if(count == array_count(buffer)){
+            return(0);
+        }
+        buffer[count++] = '0';
+    }
+
+    // note: right align into the digit lanes, leading zeros don't change the value
+    u8 digits[16];
+    memset(digits, '0', sizeof(digits));
+    memcpy(digits + sizeof(digits) - count, buffer, count);
+
+    s64 result = (s64)csv_digits16(digits);
+    if(negative){
+        result = -result;
+    }
+    return(result);
+}
+
+// note: For every delimiter the quote is whichever candidate opens more fields (follows a delimiter or a
+// newline), then the delimiter that splits the most records into the same number of fields (more than one)
+// wins, fields opened by its quote break ties, and after that the earlier candidate, so plain files stay
+// ',' and '"'. Then the fields are read with that pair, dates vote on day first and amounts on the decimal
+// separator, a separator followed by exactly 3 digits could be thousands so it doesn't vote.
+static CSVDialect
+csv_sniff_dialect(String8 data){
+    CSVDialect result = {',', '"', '.', false};
+
+    // note: whole records only
+    String8 sample = {data.str, data.size < CSV_SNIFF_SIZE ? data.size : CSV_SNIFF_SIZE};
+    if(sample.size < data.size){
+        while(sample.size && sample.str[sample.size - 1] != '\n'){
+            --sample.size;
+        }
+    }
+
+    u8 delimiters[] = {',', ';', '\t', '|'};
+    u8 quotes[] = {'"', '\''};
+    u64 best_score = 0;
+    u64 best_opens = 0;
+    for(u32 d=0; d < array_count(delimiters); ++d){
+        u64 opens[array_count(quotes)] = {0};
+        for(u64 i=0; i < sample.size; ++i){
+            if(i == 0 || sample.str[i - 1] == delimiters[d] || sample.str[i - 1] == '\n'){
+                for(u32 q=0; q < array_count(quotes); ++q){
+                    opens[q] += (sample.str[i] == quotes[q]);
+                }
+            }
+        }
+        u32 quote_idx = 0;
+        for(u32 q=1; q < array_count(quotes); ++q){
+            quote_idx = opens[q] > opens[quote_idx] ? q : quote_idx;
+        }
+
+        u32 field_counts[64];
+        u32 record_count = 0;
+        u32 count = 0;
+        CSVScanner scanner = csv_scanner(sample, delimiters[d], quotes[quote_idx]);
+        CSVField field;
+        while(record_count < array_count(field_counts) && csv_next_field(&scanner, &field)){
+            ++count;
+            if(field.end_of_record){
+                if(count > 1 || field.text.size){
+                    field_counts[record_count++] = count;
+                }
+                count = 0;
+            }
+        }
+
+        // note: score is how many records share the most common field count, times its extra fields
+        u64 score = 0;
+        for(u32 i=0; i < record_count; ++i){
+            u32 agree = 0;
+            for(u32 j=0; j < record_count; ++j){
+                agree += (field_counts[j] == field_counts[i]);
+            }
+            u64 candidate = (u64)agree * (field_counts[i] - 1);
+            score = candidate > score ? candidate : score;
+        }
+        if(score > best_score || (score && score == best_score && opens[quote_idx] > best_opens)){
+            best_score = score;
+            best_opens = opens[quote_idx];
+            result.delimiter = delimiters[d];
+            result.quote = quotes[quote_idx];
+        }
+    }
+
+    u32 dot_votes = 0;
+    u32 comma_votes = 0;
+    u32 day_votes = 0;
+    u32 month_votes = 0;
+    CSVScanner scanner = csv_scanner(sample, result.delimiter, result.quote);
+    CSVField field;
+    while(csv_next_field(&scanner, &field)){
+        String8 word = field.text;
+        str8_eat_spaces(&word);
+
+        // note: split into runs of digits and what separates them
+        u32 parts[4] = {0};
+        u32 digits[4] = {0};
+        u8 separators[3] = {0};
+        u32 part = 0;
+        bool numeric = true;
+        for(u64 i=0; i < word.size && numeric; ++i){
+            u8 c = word.str[i];
+            if(c >= '0' && c <= '9'){
+                parts[part] = parts[part] * 10 + (c - '0');
+                ++digits[part];
+            }
+            else if((c == '.' || c == ',' || c == '/' || c == '-') && digits[part]){
+                if(part == 3){
+                    numeric = false;
+                }
+                else{
+                    separators[part++] = c;
+                }
+            }
+            else if(c == '-' || c == '+' || c == '(' || c == ')' || c == ' ' || c == '$'){
+            }
+            else{
+                numeric = false;
+            }
+        }
+        if(!numeric || !digits[0]){
+            continue;
+        }
+
+        // note: three parts with matching separators is a date, anything else with a separator an amount
+        if(part == 2 && separators[0] == separators[1] && digits[2] && digits[0] <= 2 && digits[1] <= 2){
+            day_votes += (parts[0] > 12);
+            month_votes += (parts[1] > 12);
+        }
+        else if(part && digits[part] && digits[part] != 3){
+            u8 last = separators[part - 1];
+            dot_votes += (last == '.');
+            comma_votes += (last == ',');
+        }
+    }
+
+    result.decimal = (comma_votes > dot_votes) ? ',' : '.';
+    if(day_votes != month_votes){
+        result.day_first = (day_votes > month_votes);
+    }
+    else{
+        result.day_first = (result.decimal == ',');
+    }
+    return(result);
+}
+
+static u8
+csv_lower(u8 c){
+    u8 result = (c >= 'A' && c <= 'Z') ? (u8)(c + ('a' - 'A')) : c;
+    return(result);
+}
+
+// note: case insensitive FNV-1a
+static u64
+csv_alias_hash(String8 name){
+    u64 result = 0xcbf29ce484222325ull;
+    for(u64 i=0; i < name.size; ++i){
+        result ^= csv_lower(name.str[i]);
+        result *= 0x100000001b3ull;
+    }
+    return(result);
+}
+
+// note: slot for a hash under a buckets displacement, the low bits already picked the bucket so mix before masking
+static u32
+csv_alias_slot(u64 hash, u32 displacement, u32 slot_mask){
+    u64 x = hash ^ ((u64)displacement * 0x9e3779b97f4a7c15ull);
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    u32 result = (u32)x & slot_mask;
+    return(result);
+}
+
+static bool
+csv_alias_equal(String8 lower, String8 name){
+    if(lower.size != name.size){
+        return(false);
+    }
+    for(u64 i=0; i < name.size; ++i){
+        if(lower.str[i] != csv_lower(name.str[i])){
+            return(false);
+        }
+    }
+    return(true);
+}
+
+// note: builds the table into arena, names are copied so aliases can point at scratch memory.
+// Duplicate names keep the first role they were given.
+static CSVAliasTable
+csv_alias_table(Arena* arena, CSVAlias* aliases, u32 count){
+    CSVAliasTable result = {0};
+
+    u32 bucket_count = 1;
+    while(bucket_count < (count + 1) / 2){
+        bucket_count *= 2;
+    }
+    u32 slot_count = 1;
+    while(slot_count < count * 2){
+        slot_count *= 2;
+    }
+
+    ScratchArena scratch = begin_scratch();
+    u64* hashes = push_array(scratch.arena, u64, count + 1);
+    u32* next = push_array(scratch.arena, u32, count + 1);
+    u32* heads = push_array(scratch.arena, u32, bucket_count);
+    u32* sizes = push_array(scratch.arena, u32, bucket_count);
+    memset(heads, 0xff, bucket_count * sizeof(u32));
+    memset(sizes, 0, bucket_count * sizeof(u32));
+
+    // note: group aliases by bucket, dropping duplicates (they always share a bucket)
+    u32 max_size = 0;
+    for(u32 i=0; i < count; ++i){
+        hashes[i] = csv_alias_hash(aliases[i].name);
+        u32 bucket = (u32)hashes[i] & (bucket_count - 1);
+
+        bool duplicate = !aliases[i].name.size;
+        for(u32 at = heads[bucket]; at != 0xffffffff && !duplicate; at = next[at]){
+            duplicate = (hashes[at] == hashes[i] && aliases[at].name.size == aliases[i].name.size);
+            for(u64 c=0; duplicate && c < aliases[i].name.size; ++c){
+                duplicate = (csv_lower(aliases[at].name.str[c]) == csv_lower(aliases[i].name.str[c]));
+            }
+        }
+        if(duplicate){
+            continue;
+        }
+
+        next[i] = heads[bucket];
+        heads[bucket] = i;
+        ++sizes[bucket];
+        max_size = sizes[bucket] > max_size ? sizes[bucket] : max_size;
+        ++result.count;
+    }
+
+    // note: place the biggest buckets first while the table is emptiest, grow the table if a bucket can't be placed
+    u32* displacements = push_array(scratch.arena, u32, bucket_count);
+    u8* used = 0;
+    u32* taken = push_array(scratch.arena, u32, max_size + 1);
+    bool placed = false;
+    while(!placed){
+        used = push_array(scratch.arena, u8, slot_count);
+        memset(used, 0, slot_count);
+        memset(displacements, 0, bucket_count * sizeof(u32));
+
+        placed = true;
+        for(u32 size = max_size; size > 0 && placed; --size){
+            for(u32 bucket=0; bucket < bucket_count && placed; ++bucket){
+                if(sizes[bucket] != size){
+                    continue;
+                }
+
+                placed = false;
+                for(u32 displacement=0; displacement < CSV_ALIAS_MAX_DISPLACEMENT && !placed; ++displacement){
+                    u32 taken_count = 0;
+                    bool fits = true;
+                    for(u32 at = heads[bucket]; at != 0xffffffff && fits; at = next[at]){
+                        u32 slot = csv_alias_slot(hashes[at], displacement, slot_count - 1);
+                        fits = !used[slot];
+                        if(fits){
+                            used[slot] = 1;
+                            taken[taken_count++] = slot;
+                        }
+                    }
+                    if(fits){
+                        displacements[bucket] = displacement;
+                        placed = true;
+                    }
+                    else{
+                        for(u32 i=0; i < taken_count; ++i){
+                            used[taken[i]] = 0;
+                        }
+                    }
+                }
+            }
+        }
+        if(!placed){
+            slot_count *= 2;
+        }
+    }
+
+    result.bucket_mask = bucket_count - 1;
+    result.slot_mask = slot_count - 1;
+    result.displacements = push_array(arena, u32, bucket_count);
+    memcpy(result.displacements, displacements, bucket_count * sizeof(u32));
+    result.slots = push_array(arena, CSVAlias, slot_count);
+    memset(result.slots, 0, slot_count * sizeof(CSVAlias));
+
+    for(u32 bucket=0; bucket < bucket_count; ++bucket){
+        for(u32 at = heads[bucket]; at != 0xffffffff; at = next[at]){
+            CSVAlias* alias = result.slots + csv_alias_slot(hashes[at], displacements[bucket], result.slot_mask);
+            alias->role = aliases[at].role;
+            alias->name.size = aliases[at].name.size;
+            alias->name.str = push_array(arena, u8, alias->name.size);
+            for(u64 c=0; c < alias->name.size; ++c){
+                alias->name.str[c] = csv_lower(aliases[at].name.str[c]);
+            }
+        }
+    }
+
+    end_scratch(scratch);
+    return(result);
+}
+
+static CSVRole
+csv_alias_lookup(CSVAliasTable* table, String8 name){
+    if(!table->count){
+        return(CSVRole_None);
+    }
+
+    u64 hash = csv_alias_hash(name);
+    u32 displacement = table->displacements[(u32)hash & table->bucket_mask];
+    CSVAlias* alias = table->slots + csv_alias_slot(hash, displacement, table->slot_mask);
+    if(csv_alias_equal(alias->name, name)){
+        return(alias->role);
+    }
+    return(CSVRole_None);
+}
+
+static u32
+csv_worker_count(void){
+    u32 result = csv_processor_count();
+    if(result > CSV_MAX_CHUNKS){
+        result = CSV_MAX_CHUNKS;
+    }
+    if(result < 1){
+        result = 1;
+    }
+    return(result);
+}
+
+// note: copies a field into the record for the role its column has
+template<CSVRole Role>
+static void
+csv_take_field(CSVChunk* chunk, CSVRecord* record, CSVField* field){
+    if constexpr(Role == CSVRole_None){
+        return;
+    }
+    else{
+        String8 word = field->text;
+        str8_eat_spaces(&word);
+        if(field->escaped){
+            word = csv_unescape(&chunk->arena, word, chunk->dialect.quote);
+        }
+
+        if constexpr(Role == CSVRole_Date){
+            record->date = word;
+            record->date_key = csv_parse_date(word, chunk->dialect.day_first);
+        }
+        else if constexpr(Role == CSVRole_Amount){
+            // note: imported amounts are shown as spent, debits ("-12.50" or "(12.50)") drop their sign
+            record->cents = csv_parse_amount(word, chunk->dialect.decimal);
+            if(record->cents < 0){
+                record->cents = -record->cents;
+            }
+            if(str8_starts_with(word, str8_literal("-"))){
+                str8_advance(&word, 1);
+            }
+            else if(str8_starts_with(word, str8_literal("(")) && word.size > 1 && word.str[word.size - 1] == ')'){
+                str8_advance(&word, 1);
+                word.size -= 1;
+            }
+            record->amount = word;
+        }
+        else if constexpr(Role == CSVRole_Description){
+            record->description = word;
+        }
+    }
+}
+
+// note: blank lines, and the empty record between \r and \n
+static bool
+csv_blank_record(CSVField* field){
+    if(!field->end_of_record){
+        return(false);
+    }
+    String8 word = field->text;
+    str8_eat_spaces(&word);
+    return(!word.size);
+}
+
+// note: only records that ended on an actual newline are complete
+static void
+csv_end_record(CSVChunk* chunk, CSVScanner* scanner, u64* complete_count){
+    if(scanner->field_start <= chunk->data.size){
+        chunk->consumed = scanner->field_start;
+        *complete_count = chunk->record_count;
+    }
+}
+
+static u64
+csv_parse_records_generic(CSVChunk* chunk, CSVScanner* scanner){
+    CSVLayout layout = chunk->layout;
+    CSVRecord* record = 0;
+    s32 count = 0;
+    CSVField field;
+    u64 complete_count = 0;
+    while(csv_next_field(scanner, &field)){
+        if(count == 0 && csv_blank_record(&field)){
+            continue;
+        }
+
+        if(count == 0){
+            record = chunk->records + chunk->record_count++;
+            *record = {0};
+        }
+
+        if(count == layout.date_idx){
+            csv_take_field<CSVRole_Date>(chunk, record, &field);
+        }
+        else if(count == layout.amount_idx){
+            csv_take_field<CSVRole_Amount>(chunk, record, &field);
+        }
+        else if(count == layout.desc_idx){
+            csv_take_field<CSVRole_Description>(chunk, record, &field);
+        }
+
+        ++count;
+        if(field.end_of_record){
+            count = 0;
+            csv_end_record(chunk, scanner, &complete_count);
+        }
+    }
+    return(complete_count);
+}
+
+// note: One column of a record with the layout compiled in. Each column is its own instance, so which
+// role a field has is decided at compile time and the per field index compares are gone. The field of
+// this column has been read already. Returns false if the data ran out before the record ended.
+template<s32 Column, s32 DateIdx, s32 AmountIdx, s32 DescIdx, s32 ColumnCount>
+static bool
+csv_parse_column(CSVChunk* chunk, CSVScanner* scanner, CSVRecord* record, CSVField* field){
+    constexpr CSVRole role = (Column == DateIdx) ? CSVRole_Date : (Column == AmountIdx) ? CSVRole_Amount :
+                             (Column == DescIdx) ? CSVRole_Description : CSVRole_None;
+    csv_take_field<role>(chunk, record, field);
+
+    if constexpr(Column + 1 < ColumnCount){
+        if(field->end_of_record){
+            return(true);
+        }
+        if(!csv_next_field(scanner, field)){
+            return(false);
+        }
+        return(csv_parse_column<Column + 1, DateIdx, AmountIdx, DescIdx, ColumnCount>(chunk, scanner, record, field));
+    }
+    else{
+        // note: a row with more fields than the header, the extra ones are dropped
+        while(!field->end_of_record){
+            if(!csv_next_field(scanner, field)){
+                return(false);
+            }
+        }
+        return(true);
+    }
+}
+
+template<s32 DateIdx, s32 AmountIdx, s32 DescIdx, s32 ColumnCount>
+static u64
+csv_parse_records(CSVChunk* chunk, CSVScanner* scanner){
+    CSVField field;
+    u64 complete_count = 0;
+    while(csv_next_field(scanner, &field)){
+        if(csv_blank_record(&field)){
+            continue;
+        }
+
+        CSVRecord* record = chunk->records + chunk->record_count++;
+        *record = {0};
+        if(!csv_parse_column<0, DateIdx, AmountIdx, DescIdx, ColumnCount>(chunk, scanner, record, &field)){
+            break;
+        }
+        csv_end_record(chunk, scanner, &complete_count);
+    }
+    return(complete_count);
+}
+
+#define CSV_KERNEL_ENTRY(date_idx, amount_idx, desc_idx, column_count) \
+    {{date_idx, amount_idx, desc_idx, column_count}, csv_parse_records<date_idx, amount_idx, desc_idx, column_count>},
+static CSVKernelEntry csv_kernels[] = {
+    CSV_KERNEL_LAYOUTS(CSV_KERNEL_ENTRY)
+};
+#undef CSV_KERNEL_ENTRY
+
+static CSVKernel*
+csv_select_kernel(CSVLayout layout){
+    for(u32 i=0; i < array_count(csv_kernels); ++i){
+        CSVLayout* entry = &csv_kernels[i].layout;
+        if(entry->date_idx == layout.date_idx && entry->amount_idx == layout.amount_idx &&
+           entry->desc_idx == layout.desc_idx && entry->column_count == layout.column_count){
+            return(csv_kernels[i].kernel);
+        }
+    }
+    return(csv_parse_records_generic);
+}
+
+// note: parses a chunk into chunk->records, this is the whole parse for files under CSV_PARALLEL_THRESHOLD
+static void
+csv_parse_chunk(CSVChunk* chunk){
+    bool avx2 = csv_use_avx2();
+
+    // note: a record needs a newline to end it (or the end of the chunk) so this bounds the record count
+    u64 newline_count = 1;
+    for(u64 at=0; at < chunk->data.size; at += 64){
+        CSVBlock block = csv_classify_block(chunk->data.str + at, chunk->data.size - at, chunk->dialect.delimiter, 0, avx2);
+        newline_count += csv_popcount(block.newlines);
+    }
+
+    // note: plus room for unescaping, which can't be longer than the chunk itself
+    u64 arena_size = newline_count * sizeof(CSVRecord) + chunk->data.size + KB(4);
+    void* memory = csv_alloc(arena_size);
+    init_arena(&chunk->arena, (u8*)memory, arena_size);
+    chunk->records = push_array(&chunk->arena, CSVRecord, newline_count);
+    chunk->record_count = 0;
+
+    CSVScanner scanner = csv_scanner(chunk->data, chunk->dialect.delimiter, chunk->dialect.quote);
+    chunk->consumed = 0;
+    u64 complete_count = csv_select_kernel(chunk->layout)(chunk, &scanner);
+
+    // note: the window was cut mid record, that record is carried into the next window
+    if(!chunk->final){
+        chunk->record_count = complete_count;
+    }
+    else{
+        chunk->consumed = chunk->data.size;
+    }
+}
+
+static void
+csv_count_quotes(CSVChunk* chunk){
+    bool avx2 = csv_use_avx2();
+
+    chunk->quote_count = 0;
+    for(u64 at=0; at < chunk->data.size; at += 64){
+        CSVBlock block = csv_classify_block(chunk->data.str + at, chunk->data.size - at, chunk->dialect.delimiter, chunk->dialect.quote, avx2);
+        chunk->quote_count += csv_popcount(block.quotes);
+    }
+}
+
+static void
+csv_run_workers(CSVParse* parse, void (*work)(CSVChunk* chunk)){
+    for(u32 i=0; i < parse->chunk_count; ++i){
+        CSVChunk* chunk = parse->chunks + i;
+        chunk->work = work;
+        csv_thread_start(chunk);
+    }
+    for(u32 i=0; i < parse->chunk_count; ++i){
+        csv_thread_join(parse->chunks + i);
+    }
+}
+
+// note: Splits data into quote-aware chunks on record boundaries and parses them on worker threads.
+// 1. workers count the quotes in equal raw slices, the running parity says whether each slice starts inside quotes
+// 2. each slice start is moved forward to just past the first newline outside quotes
+// 3. workers parse their chunks into their own arenas
+// Chunks stay in file order, so merging them in order gives the same result as parsing serially.
+// final is false when data is a window that ends mid file, in which case the trailing partial record
+// is left unparsed and parse->consumed says where the next window has to start. worker_count is how many
+// chunks at most, callers that already parse several files at once pass what's left of csv_worker_count().
+static void
+csv_parse_chunked(CSVParse* parse, String8 data, CSVLayout layout, CSVDialect dialect, bool final, u32 worker_count){
+    *parse = {0};
+
+    worker_count = worker_count > CSV_MAX_CHUNKS ? CSV_MAX_CHUNKS : worker_count;
+    if(data.size < CSV_PARALLEL_THRESHOLD || worker_count <= 1){
+        parse->chunk_count = 1;
+        parse->chunks[0].data = data;
+        parse->chunks[0].layout = layout;
+        parse->chunks[0].dialect = dialect;
+        parse->chunks[0].final = final;
+        csv_parse_chunk(parse->chunks);
+        parse->record_count = parse->chunks[0].record_count;
+        parse->consumed = parse->chunks[0].consumed;
+        return;
+    }
+
+    parse->chunk_count = worker_count;
+    u64 raw_starts[CSV_MAX_CHUNKS + 1];
+    for(u32 i=0; i < worker_count; ++i){
+        raw_starts[i] = data.size * i / worker_count;
+    }
+    raw_starts[worker_count] = data.size;
+
+    for(u32 i=0; i < worker_count; ++i){
+        CSVChunk* chunk = parse->chunks + i;
+        chunk->data = {data.str + raw_starts[i], raw_starts[i + 1] - raw_starts[i]};
+        chunk->layout = layout;
+        chunk->dialect = dialect;
+    }
+    csv_run_workers(parse, csv_count_quotes);
+
+    u64 starts[CSV_MAX_CHUNKS + 1];
+    starts[0] = 0;
+    starts[worker_count] = data.size;
+    u64 quotes_before = 0;
+    for(u32 i=1; i < worker_count; ++i){
+        quotes_before += parse->chunks[i - 1].quote_count;
+
+        String8 rest = {data.str + raw_starts[i], data.size - raw_starts[i]};
+        CSVScanner scanner = csv_scanner(rest, dialect.delimiter, dialect.quote);
+        scanner.quote_carry = (quotes_before & 1) ? ~(u64)0 : 0;
+
+        u64 start = data.size;
+        u64 idx;
+        while(csv_next_structural(&scanner, &idx)){
+            u8 c = rest.str[idx];
+            if(c == '\n' || c == '\r'){
+                start = raw_starts[i] + idx + 1;
+                break;
+            }
+        }
+        starts[i] = start < starts[i - 1] ? starts[i - 1] : start;
+    }
+
+    // note: A slice with no newline outside quotes after its start leaves its chunk (and the ones after it) empty,
+    // so the last chunk with data is the one that can end mid record. Every chunk before it ends on a record
+    // boundary.
+    u32 last_idx = 0;
+    for(u32 i=0; i < worker_count; ++i){
+        if(starts[i + 1] > starts[i]){
+            last_idx = i;
+        }
+    }
+    for(u32 i=0; i < worker_count; ++i){
+        CSVChunk* chunk = parse->chunks + i;
+        chunk->data = {data.str + starts[i], starts[i + 1] - starts[i]};
+        chunk->final = (i == last_idx) ? final : true;
+    }
+    csv_run_workers(parse, csv_parse_chunk);
+
+    for(u32 i=0; i < worker_count; ++i){
+        parse->record_count += parse->chunks[i].record_count;
+    }
+    CSVChunk* last = parse->chunks + last_idx;
+    parse->consumed = starts[last_idx] + last->consumed;
+}
+
+static void
+csv_parse_release(CSVParse* parse){
+    for(u32 i=0; i < parse->chunk_count; ++i){
+        CSVChunk* chunk = parse->chunks + i;
+        if(chunk->arena.base){
+            csv_free(chunk->arena.base, chunk->arena.size);
+        }
+        *chunk = {0};
+    }
+    parse->chunk_count = 0;
+    parse->record_count = 0;
+    parse->consumed = 0;
+}
+
+// note: bytes of the first line including its line break, 0 if the window doesn't have a whole line
+static u64
+csv_header_line_size(String8 window){
+    u64 size = 0;
+    for(; size < window.size && window.str[size] != '\r' && window.str[size] != '\n'; ++size);
+    u64 result = size < window.size ? size + 1 : 0;
+    return(result);
+}
+
+// note: Sniffs the dialect from the window and maps the header's names to columns through the aliases
+static CSVHeader
+csv_resolve_header(String8 window, CSVAliasTable* aliases){
+    CSVHeader result = {0};
+    result.dialect = csv_sniff_dialect(window);
+    result.layout = {-1, -1, -1};
+
+    CSVScanner scanner = csv_scanner(window, result.dialect.delimiter, result.dialect.quote);
+    s32 count = 0;
+    CSVField field;
+    while(csv_next_field(&scanner, &field)){
+        String8 word = field.text;
+        str8_eat_spaces(&word);
+        CSVRole role = csv_alias_lookup(aliases, word);
+        switch(role){
+            case CSVRole_Date:{ result.layout.date_idx = count; } break;
+            case CSVRole_Amount:{ result.layout.amount_idx = count; } break;
+            case CSVRole_Description:{ result.layout.desc_idx = count; } break;
+        }
+        if(count < CSV_HEADER_COLUMNS){
+            result.names[count] = word;
+            result.roles[count] = role;
+            result.name_count = count + 1;
+        }
+        ++count;
+        if(field.end_of_record){
+            break;
+        }
+    }
+    result.layout.column_count = count;
+    result.size = scanner.field_start < window.size ? scanner.field_start : window.size;
+    return(result);
+}
+
+static CSVWindows
+csv_windows(CSVReader* reader, u64 offset, u64 window_size, CSVLayout layout, CSVDialect dialect, u32 worker_count){
+    CSVWindows result = {0};
+    result.reader = reader;
+    result.offset = offset;
+    result.window_size = window_size;
+    result.layout = layout;
+    result.dialect = dialect;
+    result.worker_count = worker_count;
+    return(result);
+}
+
+// note: false at the end of the file, otherwise csv_window_done() has to follow
+static bool
+csv_next_window(CSVWindows* windows){
+    if(windows->offset >= windows->reader->mapped->file.size){
+        return(false);
+    }
+    bool final = false;
+    windows->window = csv_reader_window(windows->reader, windows->offset, windows->window_size, &final);
+    if(!windows->window.size){
+        return(false);
+    }
+    csv_parse_chunked(&windows->parse, windows->window, windows->layout, windows->dialect, final, windows->worker_count);
+    return(true);
+}
+
+static void
+csv_window_done(CSVWindows* windows){
+    u64 consumed = windows->parse.consumed;
+    csv_parse_release(&windows->parse);
+    if(!consumed){
+        windows->window_size *= 2;
+    }
+    windows->offset += csv_reader_source_size(windows->reader, consumed);
+    windows->window = {0};
+}
+
+#endif
@@ -0,0 +1,320 @@
+#ifndef CSV_H
+#define CSV_H
+
+#include <immintrin.h>
+
+#if COMPILER_CL
+#define CSV_TARGET_AVX2
+#else
+#define CSV_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// note: Read-only file mapping with one window mapped at a time. data points straight into the mapped
+// pages, so parsing from it never buffers or copies the file, and only one window is ever resident.
+// The parser itself doesn't need win32, the posix side is what the benchmark builds with on linux.
+#if defined(_WIN32)
+typedef struct MappedFile{
+    File file;
+    HANDLE mapping;
+    u32 granularity;
+
+    u8* view;     // note: base of the mapped view (aligned down to granularity)
+    String8 data; // note: the window that was asked for
+} MappedFile;
+
+typedef HANDLE CSVThread;
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef struct MappedFile{
+    struct{
+        s32 handle; // note: file descriptor, -1 if the open failed
+        u64 size;
+    } file;
+    bool mapping;
+    u32 granularity;
+
+    u8* view;
+    u64 view_size; // note: munmap needs it
+    String8 data;
+} MappedFile;
+
+typedef pthread_t CSVThread;
+#endif
+
+// note: Structural bitmasks for one 64 byte block, bit i is byte i of the block
+typedef struct CSVBlock{
+    u64 delimiters;
+    u64 quotes;
+    u64 newlines; // '\r' and '\n'
+} CSVBlock;
+
+typedef enum CSVClass{
+    CSVClass_Other,
+    CSVClass_Delimiter,
+    CSVClass_Quote,
+    CSVClass_Newline,
+
+    CSVClass_Count,
+} CSVClass;
+
+typedef enum CSVState{
+    CSVState_FieldStart,
+    CSVState_Unquoted,
+    CSVState_Quoted,
+    CSVState_QuoteInQuoted, // note: a quote inside a quoted field, either the closing quote or the first half of ""
+
+    CSVState_Count,
+} CSVState;
+
+typedef enum CSVAction{
+    CSVAction_None,
+    CSVAction_Open,   // note: opening quote, content starts after it
+    CSVAction_Quote,  // note: possible closing quote, content ends before it
+    CSVAction_Escape, // note: it was "", the field needs unescaping
+    CSVAction_Field,
+    CSVAction_Record,
+} CSVAction;
+
+typedef struct CSVField{
+    String8 text;       // note: outer quotes already removed
+    bool escaped;       // note: text still contains "", see csv_unescape()
+    bool end_of_record;
+} CSVField;
+
+// note: Walks a buffer field by field. Blocks are classified 64 bytes at a time with SIMD and only the
+// delimiters, quotes and newlines are fed to the csv_transitions state machine, so the bytes in between
+// are never stepped through.
+// csv_next_structural walks the same buffer by structurals instead (delimiters/newlines outside quotes,
+// quotes tracked with a prefix xor), which is all chunk splitting needs.
+// A quote of 0 disables quote handling (used for line splitting our own files).
+typedef struct CSVScanner{
+    String8 data;
+    u64 block_at; // offset of the next block to classify
+
+    // note: csv_next_structural
+    u64 block_base;  // offset of the block the structurals bits belong to
+    u64 structurals; // unconsumed structural bits of the current block
+    u64 quote_carry; // all ones if the previous block ended inside quotes
+
+    // note: csv_next_field
+    u64 specials_base;
+    u64 specials;      // unconsumed delimiter/quote/newline bits of the current block
+    u64 at;            // first byte the state machine hasn't seen
+    u64 field_start;
+    u64 content_start; // note: quoted fields only
+    u64 content_end;
+    u8 state;
+    bool quoted;
+    bool escaped;
+    bool in_record;
+
+    u8 delimiter;
+    u8 quote;
+    bool avx2;
+    u8 classes[256];
+} CSVScanner;
+
+typedef enum CSVEncoding{
+    CSVEncoding_UTF8,
+    CSVEncoding_UTF16LE,
+    CSVEncoding_UTF16BE,
+    CSVEncoding_Windows1252,
+    CSVEncoding_Count,
+} CSVEncoding;
+
+// note: Hands out windows of a mapped file as utf-8. UTF-8 windows are the mapped view itself, other
+// encodings are transcoded into a buffer sized for one window, so there is never a copy of the whole file.
+typedef struct CSVReader{
+    MappedFile* mapped;
+    CSVEncoding encoding;
+    String8 raw;     // note: the mapped source bytes behind the current window
+    u8* buffer;      // note: transcoded window, unused for utf-8
+    u64 buffer_size;
+} CSVReader;
+
+// note: How a file is written, sniffed once per file from its first few KB
+typedef struct CSVDialect{
+    u8 delimiter;
+    u8 quote;
+    u8 decimal;     // note: decimal separator of amounts, the other of '.' and ',' is the thousands separator
+    bool day_first; // note: D/M/Y dates instead of M/D/Y
+} CSVDialect;
+
+#define CSV_SNIFF_SIZE KB(8)
+
+// note: Which field index holds which column, -1 if the header didn't have it. column_count is how many
+// fields the header had, 0 if unknown.
+typedef struct CSVLayout{
+    s32 date_idx;
+    s32 amount_idx;
+    s32 desc_idx;
+    s32 column_count;
+} CSVLayout;
+
+// note: Parsed row, all views into the source buffer
+typedef struct CSVRecord{
+    String8 date;
+    String8 amount;
+    String8 description;
+    u32 date_key;
+    s64 cents;
+} CSVRecord;
+
+// note: Dates are packed as (year << 9) | (month << 5) | day so they sort as integers and the month
+// can be read straight out of the key. 0 means the date didn't parse.
+#define date_key(year, month, day) (((u32)(year) << 9) | ((u32)(month) << 5) | (u32)(day))
+#define date_key_month(key) (((key) >> 5) & 0xF)
+
+// note: One workers slice of the body. data always starts and ends on a record boundary outside quotes.
+typedef struct CSVChunk{
+    String8 data;
+    CSVLayout layout;
+    CSVDialect dialect;
+
+    Arena arena; // note: owned by the worker, holds records
+    CSVRecord* records;
+    u64 record_count;
+
+    bool final;   // note: false if data ends mid record (end of a window), that record is left for the next window
+    u64 consumed; // note: bytes up to the end of the last complete record
+
+    u64 quote_count; // note: quotes in the raw (unaligned) slice, used to find where the slice starts inside quotes
+    void (*work)(CSVChunk* chunk);
+    CSVThread thread;
+} CSVChunk;
+
+// note: Which column a header name maps to
+typedef enum CSVRole{
+    CSVRole_None,
+    CSVRole_Date,
+    CSVRole_Amount,
+    CSVRole_Description,
+    CSVRole_Count,
+} CSVRole;
+
+// note: Parses a chunks records, returns how many of them ended on a newline. Layouts in CSV_KERNEL_LAYOUTS get
+// a kernel with the layout compiled in, everything else goes through the generic one.
+typedef u64 CSVKernel(CSVChunk* chunk, CSVScanner* scanner);
+
+// note: date, amount, description and column count of the bank exports we see the most
+#define CSV_KERNEL_LAYOUTS(X) \
+    X(0, 1, 2, 3) /* Date,Amount,Description */ \
+    X(0, 2, 1, 3) /* Date,Description,Amount */ \
+    X(0, 2, 1, 4) /* Date,Description,Amount,Running Bal. */ \
+    X(0, 1, 2, 4) /* Date,Amount,Description,Balance */ \
+    X(0, 3, 2, 5) /* Trans. Date,Post Date,Description,Amount,Category */ \
+    X(1, 3, 2, 5) /* Status,Date,Description,Debit,Credit */ \
+    X(0, 5, 2, 7) /* Transaction Date,Post Date,Description,Category,Type,Amount,Memo */ \
+    X(1, 3, 2, 7) /* Details,Posting Date,Description,Amount,Type,Balance,Check or Slip # */ \
+    X(0, 5, 3, 7) /* Transaction Date,Posted Date,Card No.,Description,Category,Debit,Credit */
+
+typedef struct CSVKernelEntry{
+    CSVLayout layout;
+    CSVKernel* kernel;
+} CSVKernelEntry;
+
+typedef struct CSVAlias{
+    String8 name; // note: lower case, empty for a free slot
+    CSVRole role;
+} CSVAlias;
+
+// note: Perfect hash of header names (hash and displace). A name hashes to a bucket, the buckets displacement
+// picks its slot, every alias gets a slot of its own so a lookup is one hash and one compare.
+typedef struct CSVAliasTable{
+    u32* displacements;
+    u32 bucket_mask;
+    CSVAlias* slots;
+    u32 slot_mask;
+    u32 count;
+} CSVAliasTable;
+
+#define CSV_ALIAS_MAX_DISPLACEMENT 4096 // note: tries per bucket before the table is grown
+
+#define CSV_MAX_CHUNKS 16
+#define CSV_PARALLEL_THRESHOLD MB(8)
+#define CSV_WINDOW_SIZE MB(4) // note: per chunk worker, so a window is CSV_WINDOW_SIZE * the workers parsing it
+
+typedef struct CSVParse{
+    CSVChunk chunks[CSV_MAX_CHUNKS];
+    u32 chunk_count;
+    u64 record_count;
+    u64 consumed;
+} CSVParse;
+
+// note: A header line resolved against the aliases, by csv_resolve_header(). size is how many bytes of the
+// window it takes. names are views into the window, only the first CSV_HEADER_COLUMNS are kept.
+#define CSV_HEADER_COLUMNS 16
+typedef struct CSVHeader{
+    CSVDialect dialect;
+    CSVLayout layout;
+    u64 size;
+    String8 names[CSV_HEADER_COLUMNS];
+    CSVRole roles[CSV_HEADER_COLUMNS];
+    u32 name_count;
+} CSVHeader;
+
+// note: Walks the body of a file one window of the reader at a time, the way the app and the benchmark import.
+// csv_next_window() maps the window at offset and parses it into parse, csv_window_done() releases it and moves
+// offset past the last complete record, so a record cut by the end of a window starts the next one. A single
+// record bigger than the window grows the window until it fits.
+typedef struct CSVWindows{
+    CSVReader* reader;
+    u64 offset; // note: in source bytes
+    u64 window_size;
+    CSVLayout layout;
+    CSVDialect dialect;
+    u32 worker_count;
+
+    String8 window; // note: valid until csv_window_done()
+    CSVParse parse;
+} CSVWindows;
+
+static void*      csv_alloc(u64 size);
+static void       csv_free(void* memory, u64 size);
+static MappedFile os_open_mapping(String8 path);
+static String8    os_map_view(MappedFile* mapped, u64 offset, u64 size);
+static void       os_close_mapping(MappedFile* mapped);
+static void       csv_copy_field(char* dst, u32 capacity, String8 field);
+
+static bool       cpu_has_avx2(void);
+static bool       csv_use_avx2(void);
+static CSVBlock   csv_classify_block_scalar(u8* ptr, u64 size, u8 delimiter, u8 quote);
+static CSVBlock   csv_classify_block_sse2(u8* ptr, u8 delimiter, u8 quote);
+static CSVBlock   csv_classify_block_avx2(u8* ptr, u8 delimiter, u8 quote);
+static CSVScanner csv_scanner(String8 data, u8 delimiter, u8 quote);
+static bool       csv_next_structural(CSVScanner* scanner, u64* idx);
+static bool       csv_next_field(CSVScanner* scanner, CSVField* field);
+static String8    csv_unescape(Arena* arena, String8 text, u8 quote);
+static CSVEncoding csv_detect_encoding(String8 data, u64* bom_size);
+static u64        csv_transcode(CSVEncoding encoding, String8 src, u8* dst, u64 dst_limit, u64* src_used);
+static CSVReader  csv_reader(MappedFile* mapped, u64* data_start);
+static String8    csv_reader_window(CSVReader* reader, u64 offset, u64 size, bool* final);
+static u64        csv_reader_source_size(CSVReader* reader, u64 size);
+static void       csv_reader_release(CSVReader* reader);
+
+static CSVDialect csv_sniff_dialect(String8 data);
+static u32        csv_parse_date(String8 text, bool day_first);
+static s64        csv_parse_amount(String8 text, u8 decimal);
+
+static u64           csv_alias_hash(String8 name);
+static CSVAliasTable csv_alias_table(Arena* arena, CSVAlias* aliases, u32 count);
+static CSVRole       csv_alias_lookup(CSVAliasTable* table, String8 name);
+
+static u32        csv_worker_count(void);
+static void       csv_parse_chunk(CSVChunk* chunk);
+static void       csv_parse_chunked(CSVParse* parse, String8 data, CSVLayout layout, CSVDialect dialect, bool final, u32 worker_count);
+static void       csv_parse_release(CSVParse* parse);
+
+static u64        csv_header_line_size(String8 window);
+static CSVHeader  csv_resolve_header(String8 window, CSVAliasTable* aliases);
+static CSVWindows csv_windows(CSVReader* reader, u64 offset, u64 window_size, CSVLayout layout, CSVDialect dialect, u32 worker_count);
+static bool       csv_next_window(CSVWindows* windows);
+static void       csv_window_done(CSVWindows* windows);
+
+#endif
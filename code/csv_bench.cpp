@@ -0,0 +1,646 @@
+// note: Standalone benchmark for the CSV parser and import path, build with misc\build_bench.bat on windows
+// or misc/build_bench.sh on linux.
+// 1. Runs the original str8_eat_word_csv splitter and csv_next_field over the same generated statement and
+//    checks they agree on every row the naive splitter can handle.
+// 2. Writes synthetic bank statements to disk (rows, column layout, quoting density and encoding are all
+//    options) and imports them the way the app does: mapped windows, transcoding, dialect sniffing, header
+//    aliases, chunked parsing and copying rows out. Every import is checked against the totals the
+//    generator wrote, and reports rows/s and GB/s, with the stages broken down by the profiler anchors.
+//
+// usage: csv_bench [-rows N]... [-layout name|all] [-encoding name|all] [-quote N] [-dir path] [-keep]
+// default is 10k, 1M and 50M rows of the basic layout in utf-8 with every 8th description quoted.
+
+#include "base_inc.h"
+#if defined(_WIN32)
+#include "win32_base_inc.h"
+#endif
+
+#define PROFILER 1
+#include "profiler.h"
+
+#include "csv.hpp"
+#include "csv.cpp"
+
+#define BENCH_ROWS 1000000
+#define BENCH_RUNS 5
+
+// note: every 8th description is quoted with an embedded comma, every 32nd also has escaped quotes.
+// Those are the rows the naive splitter gets wrong.
+static bool
+bench_row_is_quoted(u64 row){
+    return((row % 8) == 0);
+}
+
+static String8
+bench_generate_csv(Arena* arena, u64 rows){
+    u64 size = rows * 96 + 64;
+    char* base = (char*)push_array(arena, u8, size);
+    u64 at = 0;
+
+    at += snprintf(base + at, size - at, "Date,Amount,Description\n");
+    for(u64 row=0; row < rows; ++row){
+        u32 month = (u32)(row % 12) + 1;
+        u32 day = (u32)(row % 28) + 1;
+        u64 dollars = (row * 7919) % 5000;
+        u64 cents = row % 100;
+        if((row % 32) == 0){
+            at += snprintf(base + at, size - at, "%02u/%02u/2024,-%llu.%02llu,\"Store \"\"%llu\"\", Inc\"\n", month, day, dollars, cents, row);
+        }
+        else if(bench_row_is_quoted(row)){
+            at += snprintf(base + at, size - at, "%02u/%02u/2024,-%llu.%02llu,\"Store %llu, Inc\"\n", month, day, dollars, cents, row);
+        }
+        else{
+            at += snprintf(base + at, size - at, "%02u/%02u/2024,-%llu.%02llu,Store %llu\n", month, day, dollars, cents, row);
+        }
+    }
+
+    String8 result = {(u8*)base, at};
+    return(result);
+}
+
+static u64
+bench_hash(u64 hash, String8 string){
+    for(u64 i=0; i < string.size; ++i){
+        hash = (hash ^ string.str[i]) * 0x100000001B3;
+    }
+    return((hash ^ 0xFF) * 0x100000001B3);
+}
+
+// note: The original one-byte-at-a-time splitter and the quote stripping that went with it, kept here as the
+// baseline csv_next_field is measured against. Nothing in the app parses with them anymore.
+static bool
+str8_strip_quotes(String8* string){
+    bool result = false;
+    if(string->data[0] == '"'){
+        string->data = string->data + 1;
+        --string->count;
+        result = true;
+    }
+    if(string->data[string->count - 1] == '"'){
+        --string->count;
+        result = true;
+    }
+
+    return(result);
+}
+
+static String8
+str8_eat_word_csv(String8* string){
+    String8 result = {0};
+    str8_eat_spaces(string);
+
+    u64 count = 0;
+    while(string->count){
+        if((*string->data == ',') || (*string->data == '\n')){
+            break;
+        }
+
+        str8_advance(string, 1);
+        ++count;
+    }
+
+    result = {string->data - count, count};
+    str8_advance(string, 1);
+    return(result);
+}
+
+static void
+bench_naive(String8 data, u64* row_hashes){
+    begin_timed_bandwidth("str8_eat_word_csv", data.size);
+
+    u64 row = 0;
+    bool header = true;
+    while(data.size){
+        String8 line = str8_eat_line(&data);
+        if(header){
+            header = false;
+            continue;
+        }
+
+        u64 hash = 0xCBF29CE484222325;
+        u32 count = 0;
+        while(line.size){
+            String8 word = str8_eat_word_csv(&line);
+            if(count == 2 && word.size){
+                str8_strip_quotes(&word);
+            }
+            hash = bench_hash(hash, word);
+            ++count;
+        }
+        row_hashes[row++] = hash;
+    }
+}
+
+static void
+bench_state_machine(Arena* arena, String8 data, u64* row_hashes){
+    begin_timed_bandwidth("csv_next_field", data.size);
+
+    u64 arena_at = arena->at;
+    CSVScanner scanner = csv_scanner(data, ',', '"');
+    CSVField field;
+    u64 row = 0;
+    u64 hash = 0xCBF29CE484222325;
+    bool header = true;
+    while(csv_next_field(&scanner, &field)){
+        String8 word = field.text;
+        if(field.escaped){
+            word = csv_unescape(arena, word, '"');
+        }
+        hash = bench_hash(hash, word);
+
+        if(field.end_of_record){
+            if(!header){
+                row_hashes[row++] = hash;
+            }
+            header = false;
+            hash = 0xCBF29CE484222325;
+        }
+    }
+    arena->at = arena_at;
+}
+
+static bool
+bench_splitters(void){
+    u64 arena_size = MB(256);
+    Arena arena;
+    init_arena(&arena, (u8*)csv_alloc(arena_size), arena_size);
+
+    String8 data = bench_generate_csv(&arena, BENCH_ROWS);
+    u64* naive_hashes = push_array(&arena, u64, BENCH_ROWS);
+    u64* machine_hashes = push_array(&arena, u64, BENCH_ROWS);
+
+    begin_profiler();
+    for(u32 run=0; run < BENCH_RUNS; ++run){
+        bench_naive(data, naive_hashes);
+        bench_state_machine(&arena, data, machine_hashes);
+    }
+
+    u64 matched = 0;
+    u64 mismatched = 0;
+    u64 quoted = 0;
+    for(u64 row=0; row < BENCH_ROWS; ++row){
+        if(bench_row_is_quoted(row)){
+            ++quoted;
+        }
+        else if(naive_hashes[row] == machine_hashes[row]){
+            ++matched;
+        }
+        else{
+            ++mismatched;
+        }
+    }
+
+    print("splitters: %.2fmb, %llu rows x %u runs\n", (f64)data.size / (f64)MB(1), (u64)BENCH_ROWS, BENCH_RUNS);
+    print("unquoted rows matching the naive splitter: %llu/%llu\n", matched, matched + mismatched);
+    print("quoted rows (naive splitter shifts these): %llu\n", quoted);
+    end_profiler();
+
+    csv_free(arena.base, arena_size);
+    return(mismatched == 0);
+}
+
+///////////////////////////////
+// NOTE: Synthetic statements
+///////////////////////////////
+
+typedef enum BenchColumn{
+    BenchColumn_Date,
+    BenchColumn_Amount,
+    BenchColumn_Description,
+    BenchColumn_PostDate,
+    BenchColumn_Balance,
+    BenchColumn_Category,
+    BenchColumn_Type,
+    BenchColumn_Memo,
+    BenchColumn_Account,
+    BenchColumn_Count,
+} BenchColumn;
+
+#define BENCH_MAX_COLUMNS 8
+
+// note: eu statements are ';' separated with D/M/Y dates and decimal commas, thousands get a '.'
+typedef struct BenchLayout{
+    const char* name;
+    const char* header;
+    BenchColumn columns[BENCH_MAX_COLUMNS];
+    u32 column_count;
+    bool eu;
+} BenchLayout;
+
+// note: the first four have a specialized kernel (CSV_KERNEL_LAYOUTS), generic goes through csv_parse_records_generic
+static BenchLayout bench_layouts[] = {
+    {"basic", "Date,Amount,Description",
+     {BenchColumn_Date, BenchColumn_Amount, BenchColumn_Description}, 3, false},
+    {"running", "Date,Description,Amount,Running Bal.",
+     {BenchColumn_Date, BenchColumn_Description, BenchColumn_Amount, BenchColumn_Balance}, 4, false},
+    {"card", "Transaction Date,Post Date,Description,Category,Type,Amount,Memo",
+     {BenchColumn_Date, BenchColumn_PostDate, BenchColumn_Description, BenchColumn_Category, BenchColumn_Type, BenchColumn_Amount, BenchColumn_Memo}, 7, false},
+    {"eu", "Datum;Beschreibung;Betrag",
+     {BenchColumn_Date, BenchColumn_Description, BenchColumn_Amount}, 3, true},
+    {"generic", "Account,Date,Memo,Description,Amount,Balance",
+     {BenchColumn_Account, BenchColumn_Date, BenchColumn_Memo, BenchColumn_Description, BenchColumn_Amount, BenchColumn_Balance}, 6, false},
+};
+
+typedef enum BenchEncoding{
+    BenchEncoding_UTF8,
+    BenchEncoding_UTF8BOM,
+    BenchEncoding_UTF16LE,
+    BenchEncoding_Windows1252,
+    BenchEncoding_Count,
+} BenchEncoding;
+
+static const char* bench_encoding_names[BenchEncoding_Count] = {"utf8", "utf8bom", "utf16le", "1252"};
+
+// note: what the generator wrote, the import has to come back with the same
+typedef struct BenchTotals{
+    u64 rows;
+    s64 cents;
+    u64 bytes;
+} BenchTotals;
+
+// note: buffered file writer that encodes the utf-8 it's given on the way out
+typedef struct BenchWriter{
+    FILE* file;
+    BenchEncoding encoding;
+    u8* buffer;
+    u64 at;
+    u64 size;
+    u64 written;
+} BenchWriter;
+
+static void
+bench_flush(BenchWriter* writer){
+    fwrite(writer->buffer, 1, writer->at, writer->file);
+    writer->written += writer->at;
+    writer->at = 0;
+}
+
+static void
+bench_write(BenchWriter* writer, const char* text, u64 size){
+    if(writer->at + size * 2 > writer->size){
+        bench_flush(writer);
+    }
+
+    u8* src = (u8*)text;
+    if(writer->encoding == BenchEncoding_UTF8 || writer->encoding == BenchEncoding_UTF8BOM){
+        memcpy(writer->buffer + writer->at, src, size);
+        writer->at += size;
+        return;
+    }
+
+    // note: the generator only writes ascii and 2 byte sequences
+    for(u64 i=0; i < size; ++i){
+        u32 codepoint = src[i];
+        if(codepoint >= 0xC0 && i + 1 < size){
+            codepoint = ((codepoint & 0x1F) << 6) | (src[i + 1] & 0x3F);
+            ++i;
+        }
+        if(writer->encoding == BenchEncoding_UTF16LE){
+            writer->buffer[writer->at++] = (u8)(codepoint & 0xFF);
+            writer->buffer[writer->at++] = (u8)(codepoint >> 8);
+        }
+        else{
+            writer->buffer[writer->at++] = (u8)codepoint;
+        }
+    }
+}
+
+// note: amount text for cents, with a thousands separator in eu layouts
+static u32
+bench_format_amount(char* dst, u32 capacity, s64 cents, bool eu){
+    u64 value = (u64)(cents < 0 ? -cents : cents);
+    u64 whole = value / 100;
+    u64 fraction = value % 100;
+    const char* sign = cents < 0 ? "-" : "";
+    s32 size = 0;
+    if(eu && whole >= 1000){
+        size = snprintf(dst, capacity, "%s%llu.%03llu,%02llu", sign, whole / 1000, whole % 1000, fraction);
+    }
+    else{
+        size = snprintf(dst, capacity, "%s%llu%c%02llu", sign, whole, eu ? ',' : '.', fraction);
+    }
+    return((u32)size);
+}
+
+// note: every quote_every-th description is quoted with the delimiter in it, every 4th of those also has
+// escaped quotes. Every 16th description has an é so the encodings have something to transcode.
+static BenchTotals
+bench_write_statement(const char* path, BenchLayout* layout, BenchEncoding encoding, u64 rows, u32 quote_every){
+    BenchTotals result = {0};
+    BenchWriter writer = {0};
+    writer.file = fopen(path, "wb");
+    if(!writer.file){
+        print("Error: failed to open file <%s>\n", path);
+        return(result);
+    }
+    writer.encoding = encoding;
+    writer.size = MB(1);
+    writer.buffer = (u8*)csv_alloc(writer.size);
+
+    if(encoding == BenchEncoding_UTF8BOM){
+        bench_write(&writer, "\xEF\xBB\xBF", 3);
+    }
+    else if(encoding == BenchEncoding_UTF16LE){
+        writer.buffer[writer.at++] = 0xFF;
+        writer.buffer[writer.at++] = 0xFE;
+    }
+
+    char delimiter = layout->eu ? ';' : ',';
+    char line[512];
+    u32 at = (u32)snprintf(line, sizeof(line), "%s\n", layout->header);
+    bench_write(&writer, line, at);
+
+    for(u64 row=0; row < rows; ++row){
+        u32 month = (u32)(row % 12) + 1;
+        u32 day = (u32)(row % 28) + 1;
+        s64 cents = (s64)((row * 7919) % 500000) + (s64)(row % 100);
+        // note: imports drop the sign of debits, so the total is of what was spent
+        result.cents += cents;
+        if(row % 5){
+            cents = -cents;
+        }
+
+        at = 0;
+        for(u32 column=0; column < layout->column_count; ++column){
+            if(column){
+                line[at++] = delimiter;
+            }
+            char* dst = line + at;
+            u32 capacity = (u32)sizeof(line) - at;
+            switch(layout->columns[column]){
+                case BenchColumn_Date:
+                case BenchColumn_PostDate:{
+                    if(layout->eu){
+                        at += (u32)snprintf(dst, capacity, "%02u.%02u.2024", day, month);
+                    }
+                    else{
+                        at += (u32)snprintf(dst, capacity, "%02u/%02u/2024", month, day);
+                    }
+                } break;
+                case BenchColumn_Amount:{
+                    at += bench_format_amount(dst, capacity, cents, layout->eu);
+                } break;
+                case BenchColumn_Balance:{
+                    at += bench_format_amount(dst, capacity, (s64)(row * 31) % 10000000, layout->eu);
+                } break;
+                case BenchColumn_Description:{
+                    const char* name = (row % 16) ? "Store" : "Caf\xC3\xA9";
+                    if(quote_every && (row % quote_every) == 0){
+                        if((row % (quote_every * 4)) == 0){
+                            at += (u32)snprintf(dst, capacity, "\"%s \"\"%llu\"\"%c Inc\"", name, row, delimiter);
+                        }
+                        else{
+                            at += (u32)snprintf(dst, capacity, "\"%s %llu%c Inc\"", name, row, delimiter);
+                        }
+                    }
+                    else{
+                        at += (u32)snprintf(dst, capacity, "%s %llu", name, row);
+                    }
+                } break;
+                case BenchColumn_Category:{ at += (u32)snprintf(dst, capacity, "Groceries"); } break;
+                case BenchColumn_Type:{ at += (u32)snprintf(dst, capacity, "Sale"); } break;
+                case BenchColumn_Memo:{} break;
+                case BenchColumn_Account:{ at += (u32)snprintf(dst, capacity, "CHK-%04llu", row % 3); } break;
+            }
+        }
+        line[at++] = '\n';
+        bench_write(&writer, line, at);
+    }
+    bench_flush(&writer);
+
+    result.rows = rows;
+    result.bytes = writer.written;
+    csv_free(writer.buffer, writer.size);
+    fclose(writer.file);
+    return(result);
+}
+
+///////////////////////////////
+// NOTE: Import
+///////////////////////////////
+
+// note: where the app copies a record, same field sizes as Transaction
+typedef struct BenchRow{
+    char date[128];
+    char amount[128];
+    char description[128];
+    u32 date_key;
+    s64 cents;
+} BenchRow;
+
+typedef struct BenchImport{
+    u64 rows;
+    s64 cents;
+    u64 bad_dates;
+    u64 bytes;
+    u64 tsc;
+} BenchImport;
+
+static CSVAlias bench_aliases[] = {
+    {str8_literal("date"), CSVRole_Date},
+    {str8_literal("transaction date"), CSVRole_Date},
+    {str8_literal("datum"), CSVRole_Date},
+    {str8_literal("amount"), CSVRole_Amount},
+    {str8_literal("betrag"), CSVRole_Amount},
+    {str8_literal("description"), CSVRole_Description},
+    {str8_literal("beschreibung"), CSVRole_Description},
+};
+
+// note: imports through the same csv_resolve_header() and csv_windows() as parse_csv_file() in main.hpp, rows
+// are copied out instead of staged
+static BenchImport
+bench_import(const char* path, CSVAliasTable* aliases){
+    BenchImport result = {0};
+    u64 start = PROFILER_TIMER;
+
+    MappedFile mapped = os_open_mapping(str8((u8*)path, strlen(path)));
+    if(!mapped.mapping){
+        print("Error: failed to open file <%s>\n", path);
+        os_close_mapping(&mapped);
+        return(result);
+    }
+    result.bytes = mapped.file.size;
+    begin_timed_bandwidth("import", mapped.file.size);
+
+    u64 data_start = 0;
+    CSVReader reader = csv_reader(&mapped, &data_start);
+
+    CSVHeader header;
+    u64 offset = 0;
+    {
+        begin_timed_scope("header");
+        bool final = false;
+        String8 window = csv_reader_window(&reader, data_start, CSV_SNIFF_SIZE, &final);
+        header = csv_resolve_header(window, aliases);
+        offset = data_start + csv_reader_source_size(&reader, header.size);
+    }
+
+    BenchRow* rows = 0;
+    u64 rows_capacity = 0;
+    CSVWindows windows = csv_windows(&reader, offset, CSV_WINDOW_SIZE * csv_worker_count(), header.layout, header.dialect,
+                                     csv_worker_count());
+    for(;;){
+        {
+            begin_timed_scope("parse");
+            if(!csv_next_window(&windows)){
+                break;
+            }
+        }
+
+        {
+            begin_timed_scope("stage");
+            CSVParse* parse = &windows.parse;
+            if(parse->record_count > rows_capacity){
+                if(rows){
+                    csv_free(rows, rows_capacity * sizeof(BenchRow));
+                }
+                rows_capacity = parse->record_count * 2;
+                rows = (BenchRow*)csv_alloc(rows_capacity * sizeof(BenchRow));
+            }
+            u64 count = 0;
+            for(u32 chunk_idx=0; chunk_idx < parse->chunk_count; ++chunk_idx){
+                CSVChunk* chunk = parse->chunks + chunk_idx;
+                for(u64 record_idx=0; record_idx < chunk->record_count; ++record_idx){
+                    CSVRecord* record = chunk->records + record_idx;
+                    BenchRow* row = rows + count++;
+                    csv_copy_field(row->date, sizeof(row->date), record->date);
+                    csv_copy_field(row->amount, sizeof(row->amount), record->amount);
+                    csv_copy_field(row->description, sizeof(row->description), record->description);
+                    row->date_key = record->date_key;
+                    row->cents = record->cents;
+
+                    result.cents += record->cents;
+                    result.bad_dates += !record->date_key;
+                }
+            }
+            result.rows += count;
+        }
+        csv_window_done(&windows);
+    }
+
+    if(rows){
+        csv_free(rows, rows_capacity * sizeof(BenchRow));
+    }
+    csv_reader_release(&reader);
+    os_close_mapping(&mapped);
+    result.tsc = PROFILER_TIMER - start;
+    return(result);
+}
+
+static bool
+bench_import_case(const char* dir, BenchLayout* layout, BenchEncoding encoding, u64 rows, u32 quote_every,
+                  bool keep, CSVAliasTable* aliases, u64 cpu_freq){
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/bench_%s_%s_%llu.csv", dir, layout->name, bench_encoding_names[encoding], rows);
+
+    u64 generate_start = PROFILER_TIMER;
+    BenchTotals totals = bench_write_statement(path, layout, encoding, rows, quote_every);
+    f64 generate_seconds = (f64)(PROFILER_TIMER - generate_start) / (f64)cpu_freq;
+    if(totals.rows != rows){
+        return(false);
+    }
+
+    print("\nimport %s %s, %llu rows, %.2fmb (generated in %.2fs)\n", layout->name, bench_encoding_names[encoding],
+          rows, (f64)totals.bytes / (f64)MB(1), generate_seconds);
+
+    memset(profile_anchors, 0, sizeof(profile_anchors));
+    begin_profiler();
+    BenchImport import = bench_import(path, aliases);
+    f64 seconds = (f64)import.tsc / (f64)cpu_freq;
+    print("%.0f rows/s, %.3f GB/s\n", seconds > 0 ? (f64)import.rows / seconds : 0.0,
+          seconds > 0 ? (f64)import.bytes / (f64)GB(1) / seconds : 0.0);
+    end_profiler();
+
+    bool result = (import.rows == totals.rows && import.cents == totals.cents && !import.bad_dates);
+    if(!result){
+        print("MISMATCH: rows %llu/%llu cents %lld/%lld bad dates %llu\n",
+              import.rows, totals.rows, import.cents, totals.cents, import.bad_dates);
+    }
+    if(!keep){
+        remove(path);
+    }
+    return(result);
+}
+
+s32 main(s32 argc, char** argv){
+    u64 rows[16];
+    u32 rows_count = 0;
+    s32 layout_idx = 0;
+    s32 encoding_idx = BenchEncoding_UTF8;
+    u32 quote_every = 8;
+    const char* dir = ".";
+    bool keep = false;
+
+    // note: -1 is all of them
+    for(s32 i=1; i < argc; ++i){
+        bool has_value = (i + 1 < argc);
+        if(!strcmp(argv[i], "-rows") && has_value && rows_count < array_count(rows)){
+            rows[rows_count++] = strtoull(argv[++i], 0, 10);
+        }
+        else if(!strcmp(argv[i], "-layout") && has_value){
+            const char* name = argv[++i];
+            layout_idx = -2;
+            for(u32 l=0; l < array_count(bench_layouts); ++l){
+                if(!strcmp(name, bench_layouts[l].name)){
+                    layout_idx = (s32)l;
+                }
+            }
+            layout_idx = !strcmp(name, "all") ? -1 : layout_idx;
+        }
+        else if(!strcmp(argv[i], "-encoding") && has_value){
+            const char* name = argv[++i];
+            encoding_idx = -2;
+            for(u32 e=0; e < BenchEncoding_Count; ++e){
+                if(!strcmp(name, bench_encoding_names[e])){
+                    encoding_idx = (s32)e;
+                }
+            }
+            encoding_idx = !strcmp(name, "all") ? -1 : encoding_idx;
+        }
+        else if(!strcmp(argv[i], "-quote") && has_value){
+            quote_every = (u32)strtoul(argv[++i], 0, 10);
+        }
+        else if(!strcmp(argv[i], "-dir") && has_value){
+            dir = argv[++i];
+        }
+        else if(!strcmp(argv[i], "-keep")){
+            keep = true;
+        }
+        else{
+            layout_idx = -2;
+        }
+    }
+    if(layout_idx == -2 || encoding_idx == -2){
+        print("usage: csv_bench [-rows N]... [-layout basic|running|card|eu|generic|all] [-encoding utf8|utf8bom|utf16le|1252|all] [-quote N] [-dir path] [-keep]\n");
+        return(1);
+    }
+    if(!rows_count){
+        rows[rows_count++] = 10000;
+        rows[rows_count++] = 1000000;
+        rows[rows_count++] = 50000000;
+    }
+
+    bool ok = bench_splitters();
+
+    u64 arena_size = MB(1);
+    Arena arena;
+    init_arena(&arena, (u8*)csv_alloc(arena_size), arena_size);
+    CSVAliasTable aliases = csv_alias_table(&arena, bench_aliases, array_count(bench_aliases));
+    u64 cpu_freq = estimate_cpu_frequency();
+
+    for(u32 l=0; l < array_count(bench_layouts); ++l){
+        if(layout_idx >= 0 && (u32)layout_idx != l){
+            continue;
+        }
+        for(u32 e=0; e < BenchEncoding_Count; ++e){
+            if(encoding_idx >= 0 && (u32)encoding_idx != e){
+                continue;
+            }
+            for(u32 r=0; r < rows_count; ++r){
+                ok &= bench_import_case(dir, bench_layouts + l, (BenchEncoding)e, rows[r], quote_every, keep, &aliases, cpu_freq);
+            }
+        }
+    }
+
+    return(ok ? 0 : 1);
+}
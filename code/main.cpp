@@ -256,13 +256,10 @@ s32 WinMain(HINSTANCE instance, HINSTANCE pinstance, LPSTR command_line, s32 win
         // create pools
         pm->category_pool    = push_pool(&pm->arena, sizeof(Category), 128);
         pm->row_pool         = push_pool(&pm->arena, sizeof(Row), 1024);
-        pm->transaction_pool = push_pool(&pm->arena, sizeof(Transaction), 4096);
-        pm->data_arena       = push_arena(&pm->arena, MB(1));
 
         // setup free list from pools
         pool_free_all(pm->category_pool);
         pool_free_all(pm->row_pool);
-        pool_free_all(pm->transaction_pool);
 
         // setup sentinel node or categories
         pm->categories = (Category*)pool_next(pm->category_pool);
@@ -271,26 +268,14 @@ s32 WinMain(HINSTANCE instance, HINSTANCE pinstance, LPSTR command_line, s32 win
         // setup sentinel node for month transactions
         for(s32 i=0; i < Month_Count; ++i){
             MonthInfo* month = pm->months + i;
-            month->transactions = (Transaction*)pool_next(pm->transaction_pool);
+            month->transactions = transaction_alloc(&pm->transactions);
+            assert(month->transactions);
             dll_clear(month->transactions);
         }
         pm->month = pm->months + pm->month_tab_idx;
 
-        // give selection list memory
-        pm->selection_list = push_array(tm->options_arena, String8, 1024);
-        for(s32 i=0; i < 128; ++i){
-            String8* option = pm->selection_list + i;
-            option->str = push_array(tm->options_arena, u8, 128);
-        }
-        *pm->selection_list = str8(" \0", 2);
         pm->default_path = os_application_path(&pm->arena);
 
-        for(u32 i=0; i < 32; ++i){
-            pm->date_names[i].data = push_array(global_arena, u8, 128);
-            pm->amount_names[i].data = push_array(global_arena, u8, 128);
-            pm->desc_names[i].data = push_array(global_arena, u8, 128);
-        }
-
         pm->budget.data = push_array(global_arena, u8, 128);
         pm->draw_month_plan = true;
         pm->default_button_color = ImGui::GetStyleColorVec4(ImGuiCol_Button);
@@ -303,7 +288,9 @@ s32 WinMain(HINSTANCE instance, HINSTANCE pinstance, LPSTR command_line, s32 win
         hover_color = ImVec4(0.0f, default_hover_color.y * 0.4f, default_hover_color.z * 0.8f, default_hover_color.w);
 
         load_config();
+        load_profiles();
         deserialize_data();
+        totals_rebuild();
         pm->month_tab_flags[pm->month_tab_idx] = ImGuiTabItemFlags_SetSelected;
         pm->quarter_tab_flags[pm->quarter_tab_idx] = ImGuiTabItemFlags_SetSelected;
         pm->biannual_tab_flags[pm->biannual_tab_idx] = ImGuiTabItemFlags_SetSelected;
@@ -315,6 +302,7 @@ s32 WinMain(HINSTANCE instance, HINSTANCE pinstance, LPSTR command_line, s32 win
     should_quit = false;
     while(!should_quit){
         begin_timed_scope("while(!should_quit)");
+        import_publish();
         ImGui_ImplDX11_NewFrame();
         ImGui_ImplWin32_NewFrame();
         ImGui::NewFrame();
@@ -380,8 +368,11 @@ s32 WinMain(HINSTANCE instance, HINSTANCE pinstance, LPSTR command_line, s32 win
         //    pm->budget[0] = '0';
         //    pm->budget[1] = '\0';
         //}
-        ImGui::InputText("##Budget", (char*)pm->budget.str, 128, ImGuiInputTextFlags_CharsDecimal |
-                                                                 ImGuiInputTextFlags_AutoSelectAll);
+        if(ImGui::InputText("##Budget", (char*)pm->budget.str, 128, ImGuiInputTextFlags_CharsDecimal |
+                                                                    ImGuiInputTextFlags_AutoSelectAll)){
+            pm->budget_cents = text_to_cents((char*)pm->budget.str);
+            pm->totals_dirty = true;
+        }
         ImGui::Dummy(ImVec2(0.0f, 10.0f));
 
         // TOTALS
@@ -778,6 +769,8 @@ s32 WinMain(HINSTANCE instance, HINSTANCE pinstance, LPSTR command_line, s32 win
                     category->draw_rows = true;
                     category->row_count++;
                     pm->total_rows_count++;
+                    row_handle_acquire(r, ROW_HANDLE_NONE);
+                    totals_row_update(category, r);
                 }
                 ImGui::PopID();
 
@@ -785,7 +778,11 @@ s32 WinMain(HINSTANCE instance, HINSTANCE pinstance, LPSTR command_line, s32 win
                 ImGui::SetCursorPosX(x_column_start);
                 ImGui::PushID(c_idx);
                 if(ImGui::Button("x##remove_category")){
-                    pm->total_rows_count -= category->row_count;
+                    while(category->row_count){
+                        Row* r = category->rows->next;
+                        totals_row_remove(category, r);
+                        pool_free(pm->row_pool, r);
+                    }
                     --pm->categories_count;
 
                     dll_remove(category);
@@ -796,7 +793,8 @@ s32 WinMain(HINSTANCE instance, HINSTANCE pinstance, LPSTR command_line, s32 win
                 ImGui::SameLine();
                 ImGui::SetCursorPosX(m_column_start);
                 ImGui::PushID(c_idx);
-                if(category->muted){
+                bool category_is_muted = category_muted(category);
+                if(category_is_muted){
                     ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(1.0f, 0.0f, 0.0f, 1.0f));
                     ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(1.0f, 0.1f, 0.0f, 1.0f));
                 }
@@ -805,21 +803,7 @@ s32 WinMain(HINSTANCE instance, HINSTANCE pinstance, LPSTR command_line, s32 win
                     ImGui::PushStyleColor(ImGuiCol_ButtonHovered, pm->default_button_hovered_color);
                 }
                 if(ImGui::Button("m##mute_category")){
-                    category->muted = !category->muted;
-                    if(category->muted){
-                        Row* row = category->rows;
-                        for(s32 r_idx = 0; r_idx < category->row_count; ++r_idx){
-                            row = row->next;
-                            row->muted = true;
-                        }
-                    }
-                    else{
-                        Row* row = category->rows;
-                        for(s32 r_idx = 0; r_idx < category->row_count; ++r_idx){
-                            row = row->next;
-                            row->muted = false;
-                        }
-                    }
+                    totals_category_mute(category, !category_is_muted);
                 }
                 ImGui::PopID();
                 ImGui::PopStyleColor(2);
@@ -872,7 +856,9 @@ s32 WinMain(HINSTANCE instance, HINSTANCE pinstance, LPSTR command_line, s32 win
                         ImGui::SetCursorPosX(planned_column_start);
                         ImGui::PushItemWidth(planned_column_width);
                         String8 planned_id = str8_formatted(scratch.arena, "##planned%i%i", r_idx, c_idx);
-                        ImGui::InputText((char*)planned_id.data, row->planned, 128, ImGuiInputTextFlags_CharsDecimal | ImGuiInputTextFlags_AutoSelectAll);
+                        if(ImGui::InputText((char*)planned_id.data, row->planned, 128, ImGuiInputTextFlags_CharsDecimal | ImGuiInputTextFlags_AutoSelectAll)){
+                            totals_row_update(category, row);
+                        }
 
                         ImGui::PopItemWidth();
 
@@ -899,10 +885,7 @@ s32 WinMain(HINSTANCE instance, HINSTANCE pinstance, LPSTR command_line, s32 win
                         ImGui::SetCursorPosX(x_column_start);
                         ImGui::PushID(uid);
                         if(ImGui::Button("x##remove_row")){
-                            --pm->total_rows_count;
-                            --category->row_count;
-
-                            dll_remove(row);
+                            totals_row_remove(category, row);
                             pool_free(pm->row_pool, row);
                         }
                         ImGui::PopID();
@@ -910,7 +893,8 @@ s32 WinMain(HINSTANCE instance, HINSTANCE pinstance, LPSTR command_line, s32 win
                         ImGui::SameLine();
                         ImGui::SetCursorPosX(m_column_start);
                         ImGui::PushID(uid);
-                        if(row->muted){
+                        bool row_is_muted = row_muted(row);
+                        if(row_is_muted){
                             ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(1.0f, 0.0f, 0.0f, 1.0f));
                             ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(1.0f, 0.1f, 0.0f, 1.0f));
                         }
@@ -919,7 +903,7 @@ s32 WinMain(HINSTANCE instance, HINSTANCE pinstance, LPSTR command_line, s32 win
                             ImGui::PushStyleColor(ImGuiCol_ButtonHovered, pm->default_button_hovered_color);
                         }
                         if(ImGui::Button("m##mute_row")){
-                            row->muted = !row->muted;
+                            totals_row_mute(row, !row_is_muted);
                         }
                         ImGui::PopID();
                         ImGui::PopStyleColor(2);
@@ -928,33 +912,6 @@ s32 WinMain(HINSTANCE instance, HINSTANCE pinstance, LPSTR command_line, s32 win
                 custom_separator();
 
             }
-
-            // note: collect selection options
-            pm->selection_count = 1;
-            category = pm->categories;
-            for(s32 c_idx = 0; c_idx < pm->categories_count; ++c_idx){
-                category = category->next;
-
-                Row* row = category->rows;
-                for(s32 r_idx = 0; r_idx < category->row_count; ++r_idx){
-                    row = row->next;
-
-                    String8* selection = pm->selection_list + pm->selection_count;
-                    if(row->name[0] != '\0'){
-                        if(!char_only_spaces(row->name)){ // don't include rows that are named only spaces
-                            u32 length = char_length(row->name);
-                            String8 cat_part = str8_format(tm->frame_arena, "%s: ", category->name);
-                            String8 name_part = str8(row->name, length + 1); // + 1 to include 0 terminater
-                            String8 full = str8_concatenate(tm->frame_arena, cat_part, name_part);
-                            *selection = full;
-                        }
-                    }
-                    else{
-                        *selection = str8("", 0);
-                    }
-                    pm->selection_count++;
-                }
-            }
         }
         ImGui::EndChild();
 
@@ -1049,32 +1006,50 @@ s32 WinMain(HINSTANCE instance, HINSTANCE pinstance, LPSTR command_line, s32 win
         ImGui::SameLine();
         ImGui::SetCursorPosX(ImGui::GetColumnOffset(1) + plus_expense_column_start);
         if(ImGui::Button("+##add_transaction_button")){
-            Transaction* trans = (Transaction*)pool_next(pm->transaction_pool);
-            dll_push_back(pm->month->transactions, trans);
-
-            if(pm->month->transactions_count == 0){
-                String8 date = str8("01/01/2024\0", 11);
-                memcpy((void*)trans->date, (void*)date.str, date.size);
+            AcquireSRWLockExclusive(&pm->transaction_lock);
+            Transaction* trans = transaction_alloc(&pm->transactions);
+            ReleaseSRWLockExclusive(&pm->transaction_lock);
+            if(trans){
+                dll_push_back(pm->month->transactions, trans);
+
+                if(pm->month->transactions_count == 0){
+                    String8 date = str8("01/01/2024\0", 11);
+                    memcpy((void*)trans->date, (void*)date.str, date.size);
+                }
+                else{
+                    Transaction* last = trans->prev;
+                    memcpy((void*)trans->date, (void*)last->date, (u32)11);
+                }
+                u32 date_key = csv_parse_date(str8(trans->date, char_length(trans->date)), false);
+                if(totals_transaction_update(pm->month, trans, 0, date_key, ROW_HANDLE_UNCATEGORIZED)){
+                    pm->month->transactions_count++;
+                }
+                else{
+                    dll_remove(trans);
+                    AcquireSRWLockExclusive(&pm->transaction_lock);
+                    transaction_free(&pm->transactions, trans);
+                    ReleaseSRWLockExclusive(&pm->transaction_lock);
+                    trans = 0;
+                }
             }
-            else{
-                Transaction* last = trans->prev;
-                memcpy((void*)trans->date, (void*)last->date, (u32)11);
+            if(!trans){
+                print("Transactions: no room for another transaction\n");
             }
-            memcpy((void*)trans->selection, (void*)pm->selection_list->str, pm->selection_list->size);
-
-            pm->month->transactions_count++;
         }
 
         ImGui::SameLine();
         //ImGui::SetCursorPosX(ImGui::GetColumnOffset(1) + plus_expense_column_start);
         if(ImGui::Button("x##x_all_transactions")){
+            AcquireSRWLockExclusive(&pm->transaction_lock);
             Transaction* t = pm->month->transactions;
             for(s32 t_idx=0; t_idx < pm->month->transactions_count; ++t_idx){
                 t = t->next;
+                totals_transaction_remove(pm->month, t);
                 dll_remove(t);
-                pool_free(pm->transaction_pool, t);
+                transaction_free(&pm->transactions, t);
                 t = pm->month->transactions;
             }
+            ReleaseSRWLockExclusive(&pm->transaction_lock);
             dll_clear(pm->month->transactions);
             pm->month->transactions_count = 0;
         }
@@ -1091,37 +1066,184 @@ s32 WinMain(HINSTANCE instance, HINSTANCE pinstance, LPSTR command_line, s32 win
             ImGui::PushStyleColor(ImGuiCol_ButtonHovered, pm->default_button_hovered_color);
         }
         if(ImGui::Button("m##mute_month")){
-            pm->month->muted = !pm->month->muted;
-            if(pm->month->muted){
-                Transaction* trans = pm->month->transactions;
-                for(s32 t_idx = 0; t_idx < pm->month->transactions_count; ++t_idx){
-                    trans = trans->next;
-                    trans->muted = true;
-                }
-            }
-            else{
-                Transaction* trans = pm->month->transactions;
-                for(s32 t_idx = 0; t_idx < pm->month->transactions_count; ++t_idx){
-                    trans = trans->next;
-                    trans->muted = false;
-                }
-            }
+            totals_month_mute(pm->month, !pm->month->muted);
         }
         ImGui::PopStyleColor(2);
         ImGui::PopID();
 
         ImGui::SameLine();
-        if(ImGui::Button("Load CSV##load_csv")){
-            char* file = tinyfd_openFileDialog("Open CSV File", (char*)pm->default_path.str, 0, 0, 0, 0);
+        ImGui::BeginDisabled(import_job.active);
+        if(ImGui::Button("Load Statement##load_csv")){
+            char* file = tinyfd_openFileDialog("Open Statement", (char*)pm->default_path.str, 0, 0, 0, 0);
             if(file){
                 String8 file_path = str8(file, char_length(file));
 
-                if(str8_compare_nocase(str8_path_extension(file_path), str8_literal(".csv"))){
+                if(is_statement_path(file_path)){
                     pm->default_path = str8_path_pop(&pm->arena, file_path, '\\');
-                    load_csv(file_path);
+                    if(is_csv_path(file_path)){
+                        preview_statement(file_path);
+                    }
+                    else{
+                        load_statement(file_path);
+                    }
                 }
             }
         }
+
+        ImGui::SameLine();
+        if(ImGui::Button("Load Folder##load_csv_folder")){
+            char* folder = tinyfd_selectFolderDialog("Open Statement Folder", (char*)pm->default_path.str);
+            if(folder){
+                String8 folder_path = str8(folder, char_length(folder));
+                pm->default_path = str8_formatted(&pm->arena, "%s\\", folder);
+                load_statement_folder(folder_path);
+            }
+        }
+        ImGui::EndDisabled();
+
+        if(import_job.active){
+            f64 bytes_per_second = 0;
+            f32 progress = import_progress(&bytes_per_second);
+            String8 overlay = str8_formatted(scratch.arena, "%.0f%% %.1f MB/s", progress * 100.0f, bytes_per_second / MB(1));
+            ImGui::SameLine();
+            ImGui::ProgressBar(progress, ImVec2(200, 0), (char*)overlay.str);
+            ImGui::SameLine();
+            ImGui::BeginDisabled(import_job.cancel);
+            if(ImGui::Button("Cancel##cancel_import")){
+                import_job.cancel = true;
+            }
+            ImGui::EndDisabled();
+        }
+
+        // note: nothing is imported until the preview is confirmed
+        if(import_preview.open && !ImGui::IsPopupOpen("Import Preview")){
+            ImGui::OpenPopup("Import Preview");
+        }
+        if(ImGui::BeginPopupModal("Import Preview", 0, ImGuiWindowFlags_AlwaysAutoResize)){
+            ImportPreview* preview = &import_preview;
+            ImportFile* file = &preview->file;
+            ImGui::Text("%s", preview->path);
+            ImGui::Text("%llu rows in %.3f ms, delimiter '%c', decimal '%c'%s", file->row_count, preview->seconds * 1000.0,
+                        file->dialect.delimiter == '\t' ? 'T' : file->dialect.delimiter, file->dialect.decimal,
+                        file->dialect.day_first ? ", day first" : "");
+            if(file->resumed){
+                ImGui::Text("continues after the last import");
+            }
+
+            for(u32 c_idx=0; c_idx < preview->column_count; ++c_idx){
+                if(c_idx){
+                    ImGui::SameLine();
+                }
+                CSVRole role = preview->roles[c_idx];
+                const char* role_names[CSVRole_Count] = {"", " [date]", " [amount]", " [description]"};
+                if(role != CSVRole_None && role < CSVRole_Count){
+                    ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "%s%s", preview->columns[c_idx], role_names[role]);
+                }
+                else{
+                    ImGui::TextDisabled("%s", preview->columns[c_idx]);
+                }
+            }
+            if(file->layout.date_idx < 0 || file->layout.amount_idx < 0){
+                ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "no %s column, check the aliases in config.conf",
+                                   file->layout.date_idx < 0 ? "date" : "amount");
+            }
+
+            // note: rows are only ever matched against earlier imports of the same account, remembered for this file
+            ImGui::PushItemWidth(300);
+            ImGui::InputTextWithHint("Account##preview_account", "which account this statement is from",
+                                     file->account_name, sizeof(file->account_name));
+            ImGui::PopItemWidth();
+
+            if(ImGui::BeginTable("##preview_rows", 4, ImGuiTableFlags_Borders|ImGuiTableFlags_RowBg)){
+                ImGui::TableSetupColumn("Date");
+                ImGui::TableSetupColumn("Parsed");
+                ImGui::TableSetupColumn("Amount");
+                ImGui::TableSetupColumn("Description");
+                ImGui::TableHeadersRow();
+
+                u32 shown = 0;
+                for(StagedBlock* block = file->first; block && shown < IMPORT_PREVIEW_ROWS; block = block->next){
+                    for(u64 row_idx=0; row_idx < block->count && shown < IMPORT_PREVIEW_ROWS; ++row_idx, ++shown){
+                        StagedRow* row = block->rows + row_idx;
+                        u32 key = row->date_key;
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%s", row->trans->date);
+                        ImGui::TableNextColumn();
+                        if(key){
+                            ImGui::Text("%04u-%02u-%02u", key >> 9, date_key_month(key), key & 0x1F);
+                        }
+                        else{
+                            ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "no date");
+                        }
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%lld.%02lld", row->cents / 100, row->cents % 100);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%s", row->trans->description);
+                    }
+                }
+                ImGui::EndTable();
+            }
+
+            if(preview->error){
+                ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "%s", preview->error);
+            }
+            if(ImGui::Button("Import##preview_import")){
+                if(preview_confirm()){
+                    ImGui::CloseCurrentPopup();
+                }
+            }
+            ImGui::SameLine();
+            if(ImGui::Button("Cancel##preview_cancel")){
+                preview_discard();
+                ImGui::CloseCurrentPopup();
+            }
+            ImGui::EndPopup();
+        }
+
+        // note: rows that match an earlier import where one side didn't know its account, nothing of the
+        // import is published until they're imported or skipped
+        if(import_job.finished && import_job.staged && import_job.ambiguous_count && !import_job.ambiguous_decided &&
+           !ImGui::IsPopupOpen("Possible Duplicates")){
+            ImGui::OpenPopup("Possible Duplicates");
+        }
+        if(ImGui::BeginPopupModal("Possible Duplicates", 0, ImGuiWindowFlags_AlwaysAutoResize)){
+            ImGui::Text("%llu rows match transactions imported before, but not both statements said which account they're from.",
+                        import_job.ambiguous_count);
+            ImGui::Text("Naming the account in the import preview tells them apart next time.");
+
+            if(ImGui::BeginTable("##ambiguous_rows", 3, ImGuiTableFlags_Borders|ImGuiTableFlags_RowBg)){
+                ImGui::TableSetupColumn("Date");
+                ImGui::TableSetupColumn("Amount");
+                ImGui::TableSetupColumn("Description");
+                ImGui::TableHeadersRow();
+                for(u64 a_idx=0; a_idx < import_job.ambiguous_count && a_idx < IMPORT_PREVIEW_ROWS; ++a_idx){
+                    Transaction* ambiguous = import_job.ambiguous[a_idx].trans;
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%s", ambiguous->date);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%s", ambiguous->amount);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%s", ambiguous->description);
+                }
+                ImGui::EndTable();
+            }
+            if(import_job.ambiguous_count > IMPORT_PREVIEW_ROWS){
+                ImGui::Text("and %llu more", import_job.ambiguous_count - IMPORT_PREVIEW_ROWS);
+            }
+
+            if(ImGui::Button("Import them##ambiguous_import")){
+                import_ambiguous_decide(false);
+                ImGui::CloseCurrentPopup();
+            }
+            ImGui::SameLine();
+            if(ImGui::Button("Skip them##ambiguous_skip")){
+                import_ambiguous_decide(true);
+                ImGui::CloseCurrentPopup();
+            }
+            ImGui::EndPopup();
+        }
         custom_separator();
 
         //note: popluate amount's with 0's
@@ -1135,7 +1257,8 @@ s32 WinMain(HINSTANCE instance, HINSTANCE pinstance, LPSTR command_line, s32 win
             }
         }
 
-        // note: render transactions
+        // note: render transactions, a deleted one is removed after the loop since the loop still walks through it
+        Transaction* trans_to_remove = 0;
         trans = pm->month->transactions;
         for(s32 t_idx=0; t_idx < pm->month->transactions_count; ++t_idx){
             trans = trans->next;
@@ -1169,14 +1292,20 @@ s32 WinMain(HINSTANCE instance, HINSTANCE pinstance, LPSTR command_line, s32 win
             ImGui::SetCursorPosX(ImGui::GetColumnOffset(1) + date_column_start);
             ImGui::PushItemWidth(date_column_width);
             String8 date_id = str8_formatted(scratch.arena, "##date%i", t_idx);
-            ImGui::InputText((char*)date_id.data, trans->date, 128, ImGuiInputTextFlags_CharsDecimal);
+            if(ImGui::InputText((char*)date_id.data, trans->date, 128, ImGuiInputTextFlags_CharsDecimal)){
+                u32 date_key = csv_parse_date(str8(trans->date, char_length(trans->date)), false);
+                totals_transaction_update(pm->month, trans, transaction_cents(pm->month, trans), date_key, transaction_row_id(pm->month, trans));
+            }
             ImGui::PopItemWidth();
 
             ImGui::SameLine();
             ImGui::SetCursorPosX(ImGui::GetColumnOffset(1) + amount_column_start);
             ImGui::PushItemWidth(amount_column_width);
             String8 amount_id = str8_formatted(scratch.arena, "##amount%i", t_idx);
-            ImGui::InputText((char*)amount_id.data, trans->amount, 128, ImGuiInputTextFlags_CharsDecimal | ImGuiInputTextFlags_AutoSelectAll);
+            if(ImGui::InputText((char*)amount_id.data, trans->amount, 128, ImGuiInputTextFlags_CharsDecimal | ImGuiInputTextFlags_AutoSelectAll)){
+                s64 cents = csv_parse_amount(str8(trans->amount, char_length(trans->amount)), '.');
+                totals_transaction_update(pm->month, trans, cents, transaction_date_key(pm->month, trans), transaction_row_id(pm->month, trans));
+            }
             ImGui::PopItemWidth();
 
             ImGui::SameLine();
@@ -1197,58 +1326,55 @@ s32 WinMain(HINSTANCE instance, HINSTANCE pinstance, LPSTR command_line, s32 win
                 popup_bg_color.w = 1.0f; // Set alpha to 1.0 (fully opaque)
                 ImGui::PushStyleColor(ImGuiCol_PopupBg, ImGui::GetColorU32(popup_bg_color));
 
-                // color selection red if not found in category names
+                // note: red when the transaction was never given a row, or its row was removed
                 ImVec4 frame_bg_color = ImGui::GetStyleColorVec4(ImGuiCol_FrameBg);
-                bool found = false;
-                char space[] = " ";
-                if(!char_compare(trans->selection, space)){
-                    Category* category = pm->categories;
-                    for(s32 c_idx = 0; c_idx < pm->categories_count && !found; ++c_idx){
-                        category = category->next;
-
-                        Row* row = category->rows;
-                        for(s32 r_idx = 0; r_idx < category->row_count && !found; ++r_idx){
-                            row = row->next;
-                            String8 trans_selection = str8(trans->selection, char_length(trans->selection));
-
-                            String8 cat_part = str8_format(tm->frame_arena, "%s: ", category->name);
-                            String8 name_part = str8(row->name, char_length(row->name));
-                            String8 cat_row_name = str8_concatenate(tm->frame_arena, cat_part, name_part);
-
-                            //u32 row_length = char_length(row->name);
-                            if(cat_row_name.count == trans_selection.count){
-                                if(str8_compare(trans_selection, cat_row_name)){
-                                    found = true;
-                                }
-                            }
-                        }
-                    }
-                    if(!found){
-                        frame_bg_color.x = 1;
-                        frame_bg_color.y = 0;
-                        frame_bg_color.z = 0;
-                    }
+                u32 row_id = transaction_row_id(pm->month, trans);
+                Row* selected_row = pm->row_handles[row_id];
+                if(row_id == ROW_HANDLE_NONE){
+                    frame_bg_color.x = 1;
+                    frame_bg_color.y = 0;
+                    frame_bg_color.z = 0;
                 }
                 ImGui::PushStyleColor(ImGuiCol_FrameBg, ImGui::GetColorU32(frame_bg_color));
 
+                // note: "Category: Row" text only exists while it's drawn, transactions keep the row handle
+                String8 preview = str8_literal("");
+                if(selected_row){
+                    preview = str8_formatted(scratch.arena, "%s: %s", selected_row->category->name, selected_row->name);
+                }
+                else if(row_id == ROW_HANDLE_UNCATEGORIZED){
+                    preview = str8_literal(" ");
+                }
+
                 // populate selection box with options
                 String8 combo_id = str8_formatted(scratch.arena, "##category_select%i", t_idx);
-                if(ImGui::BeginCombo((char*)combo_id.data, trans->selection)){
-                    for (int n = 0; n < pm->selection_count; n++){
-                        String8 selection_item = pm->selection_list[n];
-                        String8 trans_selection = str8(trans->selection, char_length(trans->selection));
+                if(ImGui::BeginCombo((char*)combo_id.data, (char*)preview.str)){
+                    if(ImGui::Selectable(" ", row_id == ROW_HANDLE_UNCATEGORIZED)){
+                        totals_transaction_update(pm->month, trans, transaction_cents(pm->month, trans), transaction_date_key(pm->month, trans), ROW_HANDLE_UNCATEGORIZED);
+                    }
 
-                        if(selection_item.size == 0){
-                            continue;
-                        }
+                    Category* category = pm->categories;
+                    for(s32 c_idx = 0; c_idx < pm->categories_count; ++c_idx){
+                        category = category->next;
 
-                        const bool is_selected = str8_compare(selection_item, trans_selection);
-                        if(ImGui::Selectable((char*)selection_item.str, is_selected)){
-                            memcpy((void*)trans->selection, (void*)selection_item.str, selection_item.size + 1);
-                        }
+                        Row* row = category->rows;
+                        for(s32 r_idx = 0; r_idx < category->row_count; ++r_idx){
+                            row = row->next;
+                            if(!row->id || row->name[0] == '\0' || char_only_spaces(row->name)){ // don't include rows that are named only spaces
+                                continue;
+                            }
 
-                        if(is_selected){
-                            ImGui::SetItemDefaultFocus();
+                            const bool is_selected = (row == selected_row);
+                            String8 selection_item = str8_formatted(scratch.arena, "%s: %s", category->name, row->name);
+                            ImGui::PushID(row->id);
+                            if(ImGui::Selectable((char*)selection_item.str, is_selected)){
+                                totals_transaction_update(pm->month, trans, transaction_cents(pm->month, trans), transaction_date_key(pm->month, trans), row->id);
+                            }
+                            ImGui::PopID();
+
+                            if(is_selected){
+                                ImGui::SetItemDefaultFocus();
+                            }
                         }
                     }
                     ImGui::EndCombo();
@@ -1261,15 +1387,13 @@ s32 WinMain(HINSTANCE instance, HINSTANCE pinstance, LPSTR command_line, s32 win
             ImGui::SetCursorPosX(ImGui::GetColumnOffset(1) + x_expense_column_start);
             String8 delete_id = str8_formatted(scratch.arena, "x##remove_transaction%i", t_idx);
             if(ImGui::Button((char*)delete_id.data)){
-                pm->month->transactions_count--;
-
-                dll_remove(trans);
-                pool_free(pm->transaction_pool, trans);
+                trans_to_remove = trans;
             }
 
             ImGui::SameLine();
             ImGui::PushID(t_idx);
-            if(trans->muted){
+            bool trans_is_muted = transaction_muted(pm->month, trans);
+            if(trans_is_muted){
                 ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(1.0f, 0.0f, 0.0f, 1.0f));
                 ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(1.0f, 0.1f, 0.0f, 1.0f));
             }
@@ -1278,12 +1402,21 @@ s32 WinMain(HINSTANCE instance, HINSTANCE pinstance, LPSTR command_line, s32 win
                 ImGui::PushStyleColor(ImGuiCol_ButtonHovered, pm->default_button_hovered_color);
             }
             if(ImGui::Button("m##mute_transaction")){
-                trans->muted = !trans->muted;
+                totals_transaction_mute(pm->month, trans, !trans_is_muted);
             }
             ImGui::PopStyleColor(2);
             ImGui::PopID();
 
         }
+        if(trans_to_remove){
+            pm->month->transactions_count--;
+
+            totals_transaction_remove(pm->month, trans_to_remove);
+            dll_remove(trans_to_remove);
+            AcquireSRWLockExclusive(&pm->transaction_lock);
+            transaction_free(&pm->transactions, trans_to_remove);
+            ReleaseSRWLockExclusive(&pm->transaction_lock);
+        }
 
         ImGui::EndChild();
 
@@ -1291,284 +1424,9 @@ s32 WinMain(HINSTANCE instance, HINSTANCE pinstance, LPSTR command_line, s32 win
         ImGui::End();
 
 
-        // note: collect totals info for all months
-        for(s32 m_idx = 0; m_idx < array_count(pm->months); ++m_idx){
-            MonthInfo* month = pm->months + m_idx;
-
-            // note: collect row->spent from transactions
-            Category* category = pm->categories;
-            for(s32 c_idx = 0; c_idx < pm->categories_count; ++c_idx){
-                category = category->next;
-
-                Row* row = category->rows;
-                for(s32 r_idx = 0; r_idx < category->row_count; ++r_idx){
-                    row = row->next;
-                    row->spent = 0;
-
-                    if(!month->muted){
-                        trans = month->transactions;
-                        for(s32 t_idx = 0; t_idx < month->transactions_count; ++t_idx){
-                            trans = trans->next;
-                            if(!trans->muted){
-                                u32 t_length = char_length(trans->selection);
-                                String8 trans_selection = str8(trans->selection, t_length);
-
-                                u32 r_length = char_length(row->name);
-                                String8 cat_part = str8_format(tm->frame_arena, "%s: ", category->name);
-                                String8 name_part = str8(row->name, r_length);
-                                String8 full = str8_concatenate(tm->frame_arena, cat_part, name_part);
-                                if(str8_compare(full, trans_selection)){
-                                    f32 amount = atof(trans->amount);
-                                    row->spent += amount;
-                                    row->spent = round_to_hundredth(row->spent);
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-
-            // note: calcluate month budget/totals
-            f32 month_total_planned = 0.0f;
-            f32 month_total_spent = 0.0f;
-            f32 month_total_diff = 0.0f;
-            category = pm->categories;
-            for(s32 c_idx = 0; c_idx < pm->categories_count; ++c_idx){
-                category = category->next;
-
-                category->planned = 0;
-                category->spent = 0;
-                category->diff = 0;
-
-                Row* row = category->rows;
-                for(s32 r_idx = 0; r_idx < category->row_count; ++r_idx){
-                    row = row->next;
-                    if(!row->muted){
-                        row->diff = atof(row->planned) - row->spent;
-                        row->diff = round_to_hundredth(row->diff);
-
-                        category->planned += atof(row->planned);
-                        category->spent += row->spent;
-                        category->diff += row->diff;
-                    }
-                }
-                category->planned = round_to_hundredth(category->planned);
-                category->spent  = round_to_hundredth(category->spent);
-                category->diff    = round_to_hundredth(category->diff);
-                if(!category->muted){
-                    month_total_planned += category->planned;
-                    month_total_spent  += category->spent;
-                    month_total_diff    += category->diff;
-                }
-            }
-            if(!month->muted){
-                month->totals.planned = round_to_hundredth(month_total_planned);
-                month->totals.spent  = round_to_hundredth(month_total_spent);
-                month->totals.diff    = round_to_hundredth(month_total_diff);
-                month->totals.saved   = round_to_hundredth(atof((char*)pm->budget.str) - month->totals.spent);
-                month->totals.goal    = round_to_hundredth(atof((char*)pm->budget.str) - month->totals.planned);
-            }
-            else{
-                month->totals.planned = 0;
-                month->totals.spent  = 0;
-                month->totals.diff    = 0;
-                month->totals.saved   = 0;
-                month->totals.goal    = 0;
-            }
-        }
-
-        // note: calcluate quarterly budget/totals
-        s32 month_start = 0;
-        s32 month_end = 3;
-        for(s32 q_idx = 0; q_idx < array_count(pm->quarter_totals); ++q_idx){
-            Totals* totals = pm->quarter_totals + q_idx;
-
-            totals->planned = 0;
-            totals->spent  = 0;
-            totals->diff    = 0;
-            totals->saved   = 0;
-            totals->goal    = 0;
-            for(s32 m_idx = month_start; m_idx < month_end; ++m_idx){
-                MonthInfo* month = pm->months + m_idx;
-
-                if(!month->muted){
-                    totals->planned += month->totals.planned;
-                    totals->spent  += month->totals.spent;
-                    totals->diff    += month->totals.diff;
-                    totals->saved   += atof((char*)pm->budget.str) - month->totals.spent;
-                    totals->goal    += atof((char*)pm->budget.str) - month->totals.planned;
-                }
-            }
-            totals->planned = round_to_hundredth(totals->planned);
-            totals->spent  = round_to_hundredth(totals->spent);
-            totals->diff    = round_to_hundredth(totals->diff);
-            totals->saved   = round_to_hundredth(totals->saved);
-            totals->goal    = round_to_hundredth(totals->goal);
-
-            month_start += 3;
-            month_end += 3;
-        }
-
-        // note: calcluate biannually budget/totals
-        month_start = 0;
-        month_end = 6;
-        for(s32 q_idx = 0; q_idx < array_count(pm->biannual_totals); ++q_idx){
-            Totals* totals = pm->biannual_totals + q_idx;
-
-            totals->planned = 0;
-            totals->spent  = 0;
-            totals->diff    = 0;
-            totals->saved   = 0;
-            totals->goal    = 0;
-            for(s32 m_idx = month_start; m_idx < month_end; ++m_idx){
-                MonthInfo* month = pm->months + m_idx;
-
-                if(!month->muted){
-                    totals->planned += month->totals.planned;
-                    totals->spent  += month->totals.spent;
-                    totals->diff    += month->totals.diff;
-                    totals->saved   += atof((char*)pm->budget.str) - month->totals.spent;
-                    totals->goal    += atof((char*)pm->budget.str) - month->totals.planned;
-                }
-            }
-            totals->planned = round_to_hundredth(totals->planned);
-            totals->spent  = round_to_hundredth(totals->spent);
-            totals->diff    = round_to_hundredth(totals->diff);
-            totals->saved   = round_to_hundredth(totals->saved);
-            totals->goal    = round_to_hundredth(totals->goal);
-
-            month_start += 6;
-            month_end += 6;
-        }
-
-        // note: calcluate annual budget/totals
-        pm->annual_totals.planned = 0;
-        pm->annual_totals.spent  = 0;
-        pm->annual_totals.diff    = 0;
-        pm->annual_totals.saved   = 0;
-        pm->annual_totals.goal    = 0;
-        for(s32 m_idx = 0; m_idx < Month_Count; ++m_idx){
-            MonthInfo* month = pm->months + m_idx;
-
-            if(!month->muted){
-                pm->annual_totals.planned += month->totals.planned;
-                pm->annual_totals.spent  += month->totals.spent;
-                pm->annual_totals.diff    += month->totals.diff;
-                pm->annual_totals.saved   += atof((char*)pm->budget.str) - month->totals.spent;
-                pm->annual_totals.goal    += atof((char*)pm->budget.str) - month->totals.planned;
-            }
-        }
-        pm->annual_totals.planned = round_to_hundredth(pm->annual_totals.planned);
-        pm->annual_totals.spent  = round_to_hundredth(pm->annual_totals.spent);
-        pm->annual_totals.diff    = round_to_hundredth(pm->annual_totals.diff);
-        pm->annual_totals.saved   = round_to_hundredth(pm->annual_totals.saved);
-        pm->annual_totals.goal    = round_to_hundredth(pm->annual_totals.goal);
-
-        {
-            // note: calculate selected months row->spent
-            Category* category = pm->categories;
-            for(s32 c_idx = 0; c_idx < pm->categories_count; ++c_idx){
-                category = category->next;
-
-                Row* row = category->rows;
-                for(s32 r_idx = 0; r_idx < category->row_count; ++r_idx){
-                    row = row->next;
-                    row->spent = 0;
-
-                    if(!pm->month->muted){
-                        trans = pm->month->transactions;
-                        for(s32 t_idx = 0; t_idx < pm->month->transactions_count; ++t_idx){
-                            trans = trans->next;
-                            if(!trans->muted){
-                                u32 t_length = char_length(trans->selection);
-                                String8 trans_selection = str8(trans->selection, t_length);
-
-                                u32 r_length = char_length(row->name);
-                                String8 cat_part = str8_format(tm->frame_arena, "%s: ", category->name);
-                                String8 name_part = str8(row->name, r_length);
-                                String8 full = str8_concatenate(tm->frame_arena, cat_part, name_part);
-                                if(str8_compare(full, trans_selection)){
-                                    f32 amount = atof(trans->amount);
-                                    row->spent += amount;
-                                    row->spent = round_to_hundredth(row->spent);
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-
-            // note: calcluate selected month budget/totals
-            f32 month_total_planned = 0.0f;
-            f32 month_total_spent = 0.0f;
-            f32 month_total_diff = 0.0f;
-            category = pm->categories;
-            for(s32 c_idx = 0; c_idx < pm->categories_count; ++c_idx){
-                category = category->next;
-
-                category->planned = 0;
-                category->spent = 0;
-                category->diff = 0;
-
-                Row* row = category->rows;
-                for(s32 r_idx = 0; r_idx < category->row_count; ++r_idx){
-                    row = row->next;
-                    if(!row->muted){
-                        row->diff = atof(row->planned) - row->spent;
-                        row->diff = round_to_hundredth(row->diff);
-
-                        category->planned += atof(row->planned);
-                        category->spent += row->spent;
-                        category->diff += row->diff;
-                    }
-                }
-                category->planned = round_to_hundredth(category->planned);
-                category->spent  = round_to_hundredth(category->spent);
-                category->diff    = round_to_hundredth(category->diff);
-                if(!category->muted){
-                    month_total_planned += category->planned;
-                    month_total_spent  += category->spent;
-                    month_total_diff    += category->diff;
-                }
-            }
-            pm->month->totals.planned = round_to_hundredth(month_total_planned);
-            pm->month->totals.spent  = round_to_hundredth(month_total_spent);
-            pm->month->totals.diff    = round_to_hundredth(month_total_diff);
-            pm->month->totals.saved   = round_to_hundredth(atof((char*)pm->budget.str) - pm->month->totals.spent);
-            pm->month->totals.goal    = round_to_hundredth(atof((char*)pm->budget.str) - pm->month->totals.planned);
-        }
-
-        // note mute/unmute category based on rows muted.
-		Category* category = pm->categories;
-        for(s32 c_idx = 0; c_idx < pm->categories_count; ++c_idx){
-            category = category->next;
-
-            bool all_muted = true;
-            Row* row = category->rows;
-            for(s32 r_idx = 0; r_idx < category->row_count; ++r_idx){
-                row = row->next;
-                if(!row->muted){
-                    all_muted = false;
-                }
-            }
-
-            category->muted = all_muted;
-        }
-
-        // note mute/unmute months based on transactions muted.
-        for(s32 m_idx=0; m_idx < array_count(pm->months); ++m_idx){
-            MonthInfo* month = pm->months + m_idx;
-
-            bool all_muted = true;
-            Transaction* trans = month->transactions;
-            for(s32 t_idx = 0; t_idx < month->transactions_count; ++t_idx){
-                trans = trans->next;
-                if(!trans->muted){
-                    all_muted = false;
-                }
-            }
-
-            month->muted = all_muted;
+        // note: the sums follow every edit, the numbers shown only need refreshing when one changed them
+        if(pm->totals_dirty || pm->totals_month != pm->month){
+            totals_refresh();
         }
 
         // todo: do this once
@@ -1601,6 +1459,7 @@ s32 WinMain(HINSTANCE instance, HINSTANCE pinstance, LPSTR command_line, s32 win
         if(!os_file_exists(saves_path)){
             os_dir_create(saves_path);
         }
+        import_shutdown();
         serialize_data();
     }
 
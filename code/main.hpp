@@ -20,10 +20,16 @@
 #include "input.hpp"
 #include "clock.hpp"
 #include "d3d11_init.hpp"
+#include "csv.hpp"
+#include "ofx.hpp"
+#include "qif.hpp"
 
 #include "input.cpp"
 #include "clock.cpp"
 #include "d3d11_init.cpp"
+#include "csv.cpp"
+#include "ofx.cpp"
+#include "qif.cpp"
 
 #include "imgui/imgui.h"
 #include "imgui/imgui_impl_win32.h"
@@ -86,16 +92,36 @@ s32 WinMain(HINSTANCE instance, HINSTANCE pinstance, LPSTR command_line, s32 win
 static LRESULT win_message_handler_callback(HWND hwnd, u32 message, u64 w_param, s64 l_param);
 
 
+// note: Transactions point at their row through a handle instead of its "Category: Row" text, so renames
+// keep them attached. NONE is a transaction that was never given a row (imports) or whose row was removed,
+// the ui shows those red. UNCATEGORIZED is one the user left without a row on purpose.
+#define ROW_HANDLE_NONE 0
+#define ROW_HANDLE_UNCATEGORIZED 1
+#define ROW_HANDLE_MAX 1024 // note: same as the row pool
+
+// note: Fenwick tree of cents spent per day slot of a year. Slots give every month 31, 29, 31, ... days so
+// any year fits and a month always starts on the same slot, see day_slot(). Both adds and range sums are
+// O(log n), and since the tree is linear, trees add and subtract slot by slot.
+#define DAY_SLOTS 366
+typedef struct SpendTree{
+    s64 nodes[DAY_SLOTS + 1]; // note: 1 based
+} SpendTree;
+
 typedef struct Row{
     Row* next;
     Row* prev;
 
     char name[128];
     char planned[128];
-    f32 spent;
+    u32 id; // note: the handle transactions keep, see row_handle_acquire()
+    f32 spent; // note: of the selected month, refreshed by totals_refresh()
     f32 diff;
 
-    bool muted;
+    // note: see totals_row_update(), counted says planned_cents and spent are in the category and pm sums
+    struct Category* category;
+    s64 planned_cents;
+    SpendTree spent_days;
+    bool counted;
 } Row;
 
 typedef struct Category{
@@ -108,11 +134,17 @@ typedef struct Category{
     f32 spent;
     f32 diff;
 
+    // note: sums of the rows that aren't muted
+    s64 planned_cents;
+    SpendTree spent_days;
+
     u32 row_count;
+    u64 row_bits[ROW_HANDLE_MAX / 64]; // note: handles of its rows, muted when they're all in pm->rows_muted
     bool draw_rows;
-    bool muted;
 } Category;
 
+// note: The text of a transaction and its place in the month's list. What the totals read (cents, date key,
+// row handle, muted) only lives in the month's TransactionColumns, see transaction_cents() and friends.
 typedef struct Transaction{
     Transaction* next;
     Transaction* prev;
@@ -120,11 +152,43 @@ typedef struct Transaction{
     char date[128];
     char amount[128];
     char description[128];
-    char selection[128];
 
-    bool muted;
+    u64 fingerprint; // note: imported rows only, see fingerprint_transaction()
+
+    u32 column; // note: index + 1 into its month's TransactionColumns, 0 while it isn't stored
 } Transation;
 
+// note: Every transaction, month sentinels included, comes from one reserved range that's committed as it
+// fills, so an import of a few million rows doesn't need the pool sized for it up front. Freed transactions are
+// reused through next. alloc returns 0 once it's full or a commit fails, callers take pm->transaction_lock.
+#define TRANSACTIONS_MAX (1 << 24)
+#define TRANSACTIONS_COMMIT_STEP (1 << 14)
+typedef struct TransactionStore{
+    Transaction* base;
+    Transaction* free;
+    u32 count; // note: used from base, freed ones included
+    u32 committed;
+} TransactionStore;
+
+// note: Per month columns of the fields the totals read, so passes over every transaction (rebuild, removing
+// a row) stream a few dense arrays instead of chasing ~400 byte nodes. Text and list order stay in the nodes.
+// The columns are the only copy of those fields, so they're also what each transaction last added to the
+// totals, see totals_transaction_update().
+// Removing swaps the last transaction into the hole, nodes[] is how its column index gets fixed up.
+// All the columns of a month are one allocation that's moved to one twice the size when it fills, so a month
+// only takes memory for what it holds.
+#define COLUMNS_MAX TRANSACTIONS_MAX
+#define COLUMNS_MIN (1 << 10) // note: power of two like COLUMNS_MAX, the muted words always cover capacity
+typedef struct TransactionColumns{
+    Transaction** nodes;
+    s64* cents;
+    u32* date_keys;
+    u32* row_ids;
+    u64* muted; // note: one bit per transaction, bits past count are 0
+    u32 count;
+    u32 capacity;
+} TransactionColumns;
+
 typedef struct Totals{
     f32 planned;
     f32 spent;
@@ -139,16 +203,57 @@ typedef struct MonthInfo{
     u32 transactions_count;
 
     Totals totals;
+    TransactionColumns columns;
+    u32 unmuted_count; // note: zeros in columns.muted, the month is muted when there are none
     bool muted;
 } MonthInfo;
 
+// note: Open addressing set of imported transaction fingerprints, linear probing, 0 marks an empty slot
+typedef struct FingerprintSet{
+    u64* slots;
+    u64 capacity; // note: power of two, grown at half full
+    u64 count;
+} FingerprintSet;
+
+// note: How far a csv file has been imported, for statements that only ever grow at the end. offset is where
+// the last imported record ends in the file, anchor is a hash of the bytes of that record just before offset.
+// A source is identified by its path.
+typedef struct Watermark{
+    u64 source;
+    u64 offset;
+    u64 anchor;
+    u32 anchor_size;
+} Watermark;
+
+#define WATERMARK_MAX 256
+#define WATERMARK_ANCHOR_SIZE 128
+
+// note: The account a csv file's rows belong to, named in its preview and remembered by the file's path (source,
+// same as Watermark). Csv exports rarely say which account they're from, ofx and qif files name it themselves.
+typedef struct ImportAccount{
+    u64 source;
+    char name[64];
+} ImportAccount;
+
+#define IMPORT_ACCOUNT_MAX 256
+
+// note: How a bank's csv export is read, learned the first time its header resolves and reused every time
+// the same header comes back. header is csv_alias_hash() of the header line, terminator included. Amounts drop
+// their sign on import whatever the bank's convention, so there's no sign to keep.
+typedef struct ImportProfile{
+    u64 header;
+    CSVLayout layout;
+    CSVDialect dialect;
+} ImportProfile;
+
+#define IMPORT_PROFILE_MAX 256
+
 typedef struct PermanentMemory{
     // memory
     Arena arena;
     PoolArena* category_pool;
     PoolArena* row_pool;
-    PoolArena* transaction_pool;
-    Arena* data_arena;
+    TransactionStore transactions;
 
     // category/rows/months/transactions
     Category* categories;
@@ -160,17 +265,30 @@ typedef struct PermanentMemory{
     u32 categories_count;
     u32 transactions_count;
 
-    // for creating the transaction selection list
-	String8* selection_list;
-    u32 selection_count;
+    // note: row handle -> row, see row_handle_acquire()
+    Row* row_handles[ROW_HANDLE_MAX];
+    u64 rows_muted[ROW_HANDLE_MAX / 64]; // note: by row handle, see row_muted()
+
+    // for config loading, header name -> column
+    CSVAliasTable header_aliases;
+
+    // every transaction ever imported, so overlapping statements don't import twice, see fingerprint_key()
+    FingerprintSet fingerprints;
 
-    // for config loading
-    String8 date_names[32];
-    u32 date_names_count;
-    String8 amount_names[32];
-    u32 amount_names_count;
-    String8 desc_names[32];
-    u32 desc_names_count;
+    // transactions are also allocated from by the import thread
+    SRWLOCK transaction_lock;
+
+    // how far each csv file was imported last time, oldest first
+    Watermark watermarks[WATERMARK_MAX];
+    u32 watermarks_count;
+
+    // which account each csv file is from, oldest first
+    ImportAccount accounts[IMPORT_ACCOUNT_MAX];
+    u32 accounts_count;
+
+    // known csv headers, oldest first, saved to profiles.conf next to config.conf
+    ImportProfile profiles[IMPORT_PROFILE_MAX];
+    u32 profiles_count;
 
     // for setting tab flags
     u32 month_tab_flags[12];
@@ -190,6 +308,14 @@ typedef struct PermanentMemory{
     Totals biannual_totals[2];
     Totals annual_totals;
 
+    // note: Totals are kept up to date by the edits themselves (totals_*_update) instead of being recomputed
+    // every frame. The Totals and the rows/categories f32s are only refreshed when something changed.
+    s64 planned_cents; // note: rows that aren't muted, the same for every month
+    s64 budget_cents;
+    SpendTree spent_days; // note: rows that aren't muted, muted months have nothing spent
+    MonthInfo* totals_month; // note: the month the rows and categories f32s were refreshed for
+    bool totals_dirty;
+
     bool draw_month_plan;
     f32 hover_time;
     f32 epsilon;
@@ -374,44 +500,6 @@ str8_strip_newline(String8* string){
     return(result);
 }
 
-// todo: verify that I need to do this
-static bool
-str8_strip_quotes(String8* string){
-    bool result = false;
-    if(string->data[0] == '"'){
-        string->data = string->data + 1;
-        --string->count;
-        result = true;
-    }
-    if(string->data[string->count - 1] == '"'){
-        --string->count;
-        result = true;
-    }
-
-    return(result);
-}
-
-static String8
-str8_eat_word_csv(String8* string){
-    String8 result = {0};
-    str8_eat_spaces(string);
-
-    u64 count = 0;
-    while(string->count){
-        if((*string->data == ',') || (*string->data == '\n')){
-            break;
-        }
-
-        str8_advance(string, 1);
-        ++count;
-    }
-
-    result = {string->data - count, count};
-    str8_advance(string, 1);
-    return(result);
-}
-
-
 //static String8
 //str8_next_csv_word(String8* string){
 //    String8 result = {0};
@@ -438,219 +526,2567 @@ str8_eat_word_csv(String8* string){
 //    return(result);
 //}
 
-typedef enum ParsingState{
-    ParsingState_None,
-    ParsingState_Budget,
-    ParsingState_Category,
-    ParsingState_Row,
-    ParsingState_Month,
-    ParsingState_Transaction,
-    ParsingState_Config,
+// note: first slot of each month and one past the last slot of december, see SpendTree
+global u32 month_first_slot[Month_Count + 1] = {0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335, DAY_SLOTS};
 
-    ParsingState_Date,
-    ParsingState_Amount,
-    ParsingState_Description,
+// note: The slot a transaction of a month's list is spent on. The list decides the month like it always has,
+// the date only picks the day, a date that didn't parse or belongs to another month counts on the 1st.
+static u32
+day_slot(u32 m_idx, u32 date_key){
+    u32 day = 1;
+    if(date_key && date_key_month(date_key) == m_idx + 1 && (date_key & 0x1F)){
+        day = date_key & 0x1F;
+    }
+    u32 days = month_first_slot[m_idx + 1] - month_first_slot[m_idx];
+    u32 result = month_first_slot[m_idx] + (day < days ? day : days) - 1;
+    return(result);
+}
 
-    ParsingState_Count,
-} ParsingState;
+static void
+spend_tree_add(SpendTree* tree, u32 slot, s64 delta){
+    for(u32 i = slot + 1; i <= DAY_SLOTS; i += i & (0 - i)){
+        tree->nodes[i] += delta;
+    }
+}
 
-ParsingState state = ParsingState_None;
+// note: sum of the slots before end
+static s64
+spend_tree_prefix(SpendTree* tree, u32 end){
+    s64 result = 0;
+    for(u32 i = end; i > 0; i -= i & (0 - i)){
+        result += tree->nodes[i];
+    }
+    return(result);
+}
 
-static void
-load_csv(String8 full_path){
+// note: sum of slots [first, end)
+static s64
+spend_tree_range(SpendTree* tree, u32 first, u32 end){
+    s64 result = spend_tree_prefix(tree, end) - spend_tree_prefix(tree, first);
+    return(result);
+}
 
-    File file = os_file_open(full_path, GENERIC_READ, OPEN_EXISTING);
-    if(!file.size){
-        //todo: log error
-        print("Error: failed to open file <%s>\n", full_path.str);
-        os_file_close(file);
-        return;
+// note: turns plain per slot values (nodes[slot + 1]) into a tree in O(n)
+static void
+spend_tree_build(SpendTree* tree){
+    for(u32 i=1; i <= DAY_SLOTS; ++i){
+        u32 parent = i + (i & (0 - i));
+        if(parent <= DAY_SLOTS){
+            tree->nodes[parent] += tree->nodes[i];
+        }
     }
-    ScratchArena scratch = begin_scratch();
+}
 
-    String8 data = os_file_read(scratch.arena, file);
-    String8* ptr = &data;
+// note: dst += src * sign
+static void
+spend_tree_merge(SpendTree* dst, SpendTree* src, s64 sign){
+    for(u32 i=1; i <= DAY_SLOTS; ++i){
+        dst->nodes[i] += src->nodes[i] * sign;
+    }
+}
 
-    state = ParsingState_None;
-    s32 date_idx = -1;
-    s32 amount_idx = -1;
-    s32 desc_idx = -1;
-    bool header = true;
-    String8 line = {0};
-    while(ptr->size){
-        line = str8_eat_line(ptr);
-
-        if(header){
-            String8 word;
-            u32 word_count = 0;
-            while(line.size){
-                word = str8_eat_word_csv(&line);
-                for(u32 i=0; i < 32; ++i){
-                    if(str8_compare(pm->date_names[i], word)){
-                        date_idx = word_count;
-                    }
-                    else if(str8_compare(pm->amount_names[i], word)){
-                        amount_idx = word_count;
-                    }
-                    else if(str8_compare(pm->desc_names[i], word)){
-                        desc_idx = word_count;
-                    }
-                }
-                ++word_count;
+static Transaction*
+transaction_alloc(TransactionStore* store){
+    Transaction* result = store->free;
+    if(result){
+        store->free = result->next;
+    }
+    else{
+        if(!store->base){
+            store->base = (Transaction*)VirtualAlloc(0, (u64)TRANSACTIONS_MAX * sizeof(Transaction), MEM_RESERVE, PAGE_READWRITE);
+            if(!store->base){
+                return(0);
+            }
+        }
+        if(store->count == store->committed){
+            if(store->committed == TRANSACTIONS_MAX){
+                return(0);
+            }
+            if(!VirtualAlloc(store->base + store->committed, TRANSACTIONS_COMMIT_STEP * sizeof(Transaction), MEM_COMMIT, PAGE_READWRITE)){
+                return(0);
             }
-            header = false;
+            store->committed += TRANSACTIONS_COMMIT_STEP;
         }
+        result = store->base + store->count++;
+    }
+    memset(result, 0, sizeof(Transaction));
+    return(result);
+}
 
-        else if(line.size){
-            Transaction* trans = (Transaction*)pool_next(pm->transaction_pool);
-            dll_push_back(pm->month->transactions, trans);
-            ++pm->month->transactions_count;
+static void
+transaction_free(TransactionStore* store, Transaction* trans){
+    trans->next = store->free;
+    store->free = trans;
+}
 
-            u32 count = 0;
-            String8 word;
-            while(line.size){
-                word = str8_eat_word_csv(&line);
-                str8_strip_newline(&word);
-                if(count == date_idx){
-                    if(word.size == 0){
-                        copy_word_to_char(trans->date, str8_literal("\0"));
-                    }
-                    else{
-                        copy_word_to_char(trans->date, word);
-                    }
-                }
-                else if(count == amount_idx){
-                    if(word.size == 0){
-                        copy_word_to_char(trans->amount, str8_literal("\0"));
-                    }
-                    else{
-                        if(str8_starts_with(word, str8_literal("-"))){
-                            str8_advance(&word, 1);
-                        }
-                        copy_word_to_char(trans->amount, word);
-                    }
-                }
-                else if(count == desc_idx){
-                    if(word.size == 0){
-                        copy_word_to_char(trans->description, str8_literal("\0"));
-                    }
-                    else{
-                        String8* view = &word;
-                        str8_strip_quotes(view);
-                        copy_word_to_char(trans->description, *view);
-                    }
-                }
+// note: Makes room for count transactions, false if that's more than COLUMNS_MAX or the memory can't be had.
+// Growing copies the columns into a new allocation, what's stored is left as it was either way.
+static bool
+columns_reserve(TransactionColumns* columns, u64 count){
+    if(count <= columns->capacity){
+        return(true);
+    }
+    if(count > COLUMNS_MAX){
+        return(false);
+    }
+    u64 capacity = columns->capacity ? (u64)columns->capacity * 2 : COLUMNS_MIN;
+    while(capacity < count){
+        capacity *= 2;
+    }
 
-                ++count;
-            }
-        }
+    u64 size = capacity * (sizeof(Transaction*) + sizeof(s64) + sizeof(u32) + sizeof(u32)) + capacity / 8;
+    u8* base = (u8*)VirtualAlloc(0, size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+    if(!base){
+        return(false);
     }
+    TransactionColumns grown = {0};
+    grown.nodes     = (Transaction**)base;
+    grown.cents     = (s64*)(grown.nodes + capacity);
+    grown.date_keys = (u32*)(grown.cents + capacity);
+    grown.row_ids   = grown.date_keys + capacity;
+    grown.muted     = (u64*)(grown.row_ids + capacity);
+    grown.count     = columns->count;
+    grown.capacity  = (u32)capacity;
+    if(columns->nodes){
+        memcpy(grown.nodes, columns->nodes, columns->count * sizeof(Transaction*));
+        memcpy(grown.cents, columns->cents, columns->count * sizeof(s64));
+        memcpy(grown.date_keys, columns->date_keys, columns->count * sizeof(u32));
+        memcpy(grown.row_ids, columns->row_ids, columns->count * sizeof(u32));
+        memcpy(grown.muted, columns->muted, (columns->count + 63) / 64 * sizeof(u64));
+        VirtualFree(columns->nodes, 0, MEM_RELEASE);
+    }
+    *columns = grown;
+    return(true);
+}
 
-    state = ParsingState_None;
-    os_file_close(file);
-    end_scratch(scratch);
+static void
+columns_release(TransactionColumns* columns){
+    if(columns->nodes){
+        VirtualFree(columns->nodes, 0, MEM_RELEASE);
+    }
+    *columns = {0};
+}
+
+static bool
+columns_muted(TransactionColumns* columns, u32 idx){
+    bool result = (columns->muted[idx / 64] >> (idx % 64)) & 1;
+    return(result);
 }
 
 static void
-load_config(void){
-    ScratchArena scratch = begin_scratch();
-    String8 full_path = str8_path_append(scratch.arena, build_path, str8_literal("config.conf"));
+columns_set_muted(TransactionColumns* columns, u32 idx, bool muted){
+    u64 bit = (u64)1 << (idx % 64);
+    columns->muted[idx / 64] = muted ? (columns->muted[idx / 64] | bit) : (columns->muted[idx / 64] & ~bit);
+}
 
-    File file = os_file_open(full_path, GENERIC_READ, OPEN_EXISTING);
-    if(!file.size){
-        //todo: log error
-        print("Error: failed to open file <%s>\n", full_path.str);
-        os_file_close(file);
-        end_scratch(scratch);
+// note: Sets the fields the totals read, adding the transaction (unmuted) if it isn't stored yet. Only adding
+// can fail, see columns_reserve().
+static bool
+columns_store(TransactionColumns* columns, Transaction* trans, s64 cents, u32 date_key, u32 row_id){
+    if(!trans->column){
+        if(!columns_reserve(columns, (u64)columns->count + 1)){
+            return(false);
+        }
+        columns->nodes[columns->count] = trans;
+        trans->column = ++columns->count;
+    }
+    u32 idx = trans->column - 1;
+    columns->cents[idx] = cents;
+    columns->date_keys[idx] = date_key;
+    columns->row_ids[idx] = row_id;
+    return(true);
+}
+
+static bool
+transaction_muted(MonthInfo* month, Transaction* trans){
+    bool result = trans->column && columns_muted(&month->columns, trans->column - 1);
+    return(result);
+}
+
+static s64
+transaction_cents(MonthInfo* month, Transaction* trans){
+    s64 result = trans->column ? month->columns.cents[trans->column - 1] : 0;
+    return(result);
+}
+
+static u32
+transaction_date_key(MonthInfo* month, Transaction* trans){
+    u32 result = trans->column ? month->columns.date_keys[trans->column - 1] : 0;
+    return(result);
+}
+
+static u32
+transaction_row_id(MonthInfo* month, Transaction* trans){
+    u32 result = trans->column ? month->columns.row_ids[trans->column - 1] : ROW_HANDLE_NONE;
+    return(result);
+}
+
+static void
+columns_drop(TransactionColumns* columns, Transaction* trans){
+    if(!trans->column){
         return;
     }
+    u32 idx = trans->column - 1;
+    u32 last = --columns->count;
+    if(idx != last){
+        columns->nodes[idx] = columns->nodes[last];
+        columns->cents[idx] = columns->cents[last];
+        columns->date_keys[idx] = columns->date_keys[last];
+        columns->row_ids[idx] = columns->row_ids[last];
+        columns_set_muted(columns, idx, columns_muted(columns, last));
+        columns->nodes[idx]->column = idx + 1;
+    }
+    columns_set_muted(columns, last, false);
+    trans->column = 0;
+}
 
-    String8 data = os_file_read(scratch.arena, file);
-    String8* ptr = &data;
+static u32
+columns_unmuted(TransactionColumns* columns){
+    u32 muted = 0;
+    for(u32 i=0; i < (columns->count + 63) / 64; ++i){
+        muted += (u32)csv_popcount(columns->muted[i]);
+    }
+    return(columns->count - muted);
+}
 
-    state = ParsingState_None;
-    String8 line = {0};
-    while(ptr->size){
-        line = str8_eat_line(ptr);
-        if(str8_starts_with(line, str8_literal("#"))){
-            if(str8_compare(line, str8_literal("#date\n"))){
-                state = ParsingState_Date;
-            }
-            else if(str8_compare(line, str8_literal("#amount\n"))){
-                state = ParsingState_Amount;
-            }
-            else if(str8_compare(line, str8_literal("#description\n"))){
-                state = ParsingState_Description;
-            }
+// note: gives every transaction spent from row_id ROW_HANDLE_NONE instead
+static void
+columns_clear_row_scalar(TransactionColumns* columns, u32 row_id, u32 at){
+    for(; at < columns->count; ++at){
+        if(columns->row_ids[at] == row_id){
+            columns->row_ids[at] = ROW_HANDLE_NONE;
         }
-        else if(state == ParsingState_Date){
-            String8 word;
-            while(line.size){
-                word = str8_eat_word_csv(&line);
-                String8* str = pm->date_names + pm->date_names_count;
-                ++pm->date_names_count;
+    }
+}
 
-                memcpy(str->data, word.data, word.count);
-                str->count = word.count;
-                str8_strip_newline(str);
-            }
+CSV_TARGET_AVX2 static void
+columns_clear_row_avx2(TransactionColumns* columns, u32 row_id){
+    __m256i wanted = _mm256_set1_epi32((s32)row_id);
+    __m256i none = _mm256_set1_epi32(ROW_HANDLE_NONE);
+    u32 at = 0;
+    for(; at + 8 <= columns->count; at += 8){
+        __m256i ids = _mm256_loadu_si256((__m256i*)(columns->row_ids + at));
+        __m256i matches = _mm256_cmpeq_epi32(ids, wanted);
+        _mm256_storeu_si256((__m256i*)(columns->row_ids + at), _mm256_blendv_epi8(ids, none, matches));
+    }
+    columns_clear_row_scalar(columns, row_id, at);
+}
+
+static void
+columns_clear_row(TransactionColumns* columns, u32 row_id){
+    if(csv_use_avx2()){
+        columns_clear_row_avx2(columns, row_id);
+    }
+    else{
+        columns_clear_row_scalar(columns, row_id, 0);
+    }
+}
+
+// note: day_slot() of count date keys of month m_idx
+static void
+columns_day_slots_scalar(u32 m_idx, u32* date_keys, u32 count, u32* slots){
+    for(u32 i=0; i < count; ++i){
+        slots[i] = day_slot(m_idx, date_keys[i]);
+    }
+}
+
+CSV_TARGET_AVX2 static void
+columns_day_slots_avx2(u32 m_idx, u32* date_keys, u32 count, u32* slots){
+    __m256i month = _mm256_set1_epi32((s32)m_idx + 1);
+    __m256i first = _mm256_set1_epi32((s32)month_first_slot[m_idx] - 1);
+    __m256i days  = _mm256_set1_epi32((s32)(month_first_slot[m_idx + 1] - month_first_slot[m_idx]));
+    __m256i one   = _mm256_set1_epi32(1);
+    __m256i zero  = _mm256_setzero_si256();
+    u32 i = 0;
+    for(; i + 8 <= count; i += 8){
+        __m256i keys = _mm256_loadu_si256((__m256i*)(date_keys + i));
+        __m256i key_day = _mm256_and_si256(keys, _mm256_set1_epi32(0x1F));
+        __m256i key_month = _mm256_and_si256(_mm256_srli_epi32(keys, 5), _mm256_set1_epi32(0xF));
+        __m256i valid = _mm256_andnot_si256(_mm256_cmpeq_epi32(key_day, zero), _mm256_cmpeq_epi32(key_month, month));
+        __m256i day = _mm256_blendv_epi8(one, key_day, valid);
+        day = _mm256_min_epu32(day, days);
+        _mm256_storeu_si256((__m256i*)(slots + i), _mm256_add_epi32(first, day));
+    }
+    columns_day_slots_scalar(m_idx, date_keys + i, count - i, slots + i);
+}
+
+// note: Adds every unmuted transaction of the month into its row's spent_days as plain per slot cents, the
+// caller turns those into trees with spend_tree_build(). Slots are worked out a batch at a time. The adds
+// stay scalar: they land on whichever row each transaction is spent from, AVX2 has no scatter, and gathering
+// the row pointers four at a time to do the same four adds measured slower than this loop.
+static void
+columns_spend_days(u32 m_idx, TransactionColumns* columns){
+    bool avx2 = csv_use_avx2();
+    u32 slots[256];
+    for(u32 at=0; at < columns->count; at += array_count(slots)){
+        u32 count = columns->count - at < array_count(slots) ? columns->count - at : array_count(slots);
+        if(avx2){
+            columns_day_slots_avx2(m_idx, columns->date_keys + at, count, slots);
+        }
+        else{
+            columns_day_slots_scalar(m_idx, columns->date_keys + at, count, slots);
         }
-        else if(state == ParsingState_Amount){
-            String8 word;
-            while(line.size){
-                word = str8_eat_word_csv(&line);
-                String8* str = pm->amount_names + pm->amount_names_count;
-                ++pm->amount_names_count;
 
-                memcpy(str->data, word.data, word.count);
-                str->count = word.count;
-                str8_strip_newline(str);
+        for(u32 i=0; i < count; ++i){
+            u32 idx = at + i;
+            Row* row = pm->row_handles[columns->row_ids[idx]];
+            if(row && !columns_muted(columns, idx)){
+                row->spent_days.nodes[slots[i] + 1] += columns->cents[idx];
             }
         }
-        else if(state == ParsingState_Description){
-            String8 word;
-            while(line.size){
-                word = str8_eat_word_csv(&line);
-                String8* str = pm->desc_names + pm->desc_names_count;
-                ++pm->desc_names_count;
+    }
+}
+
+// note: Totals are sums of cents kept current by the edits that change them, each edit only applies its own
+// difference: transaction -> row -> category -> pm, as day slots so any date range can be asked for. A
+// transaction's columns remember what it added and a row whether its figures are in the sums (counted), so
+// an update takes the old contribution back out and puts the new one in without knowing what the edit was.
+static f32
+cents_to_f32(s64 cents){
+    f32 result = (f32)((f64)cents / 100.0);
+    return(result);
+}
+
+static s64
+text_to_cents(char* text){
+    s64 result = csv_parse_amount(str8(text, char_length(text)), '.');
+    return(result);
+}
+
+static u32
+row_handle_acquire(Row* row, u32 wanted){
+    row->id = ROW_HANDLE_NONE;
+    if(wanted > ROW_HANDLE_UNCATEGORIZED && wanted < ROW_HANDLE_MAX && !pm->row_handles[wanted]){
+        row->id = wanted;
+    }
+    for(u32 id = ROW_HANDLE_UNCATEGORIZED + 1; !row->id && id < ROW_HANDLE_MAX; ++id){
+        if(!pm->row_handles[id]){
+            row->id = id;
+        }
+    }
+    pm->row_handles[row->id] = row->id ? row : 0;
+    return(row->id);
+}
+
+static void
+row_handle_release(Row* row){
+    if(row->id){
+        pm->row_handles[row->id] = 0;
+    }
+    row->id = ROW_HANDLE_NONE;
+}
 
-                memcpy(str->data, word.data, word.count);
-                str->count = word.count;
-                str8_strip_newline(str);
+// note: only for budget files from before row handles, which stored the "Category: Row" text
+static u32
+row_handle_from_selection(String8 selection){
+    if(str8_compare(selection, str8_literal(" "))){
+        return(ROW_HANDLE_UNCATEGORIZED);
+    }
+    Category* category = pm->categories;
+    for(s32 c_idx = 0; c_idx < pm->categories_count; ++c_idx){
+        category = category->next;
+        u32 category_length = char_length(category->name);
+        if(selection.size < category_length + 2 || memcmp(selection.str, category->name, category_length) ||
+           selection.str[category_length] != ':' || selection.str[category_length + 1] != ' '){
+            continue;
+        }
+        String8 row_name = str8(selection.str + category_length + 2, selection.size - category_length - 2);
+        Row* row = category->rows;
+        for(s32 r_idx = 0; r_idx < category->row_count; ++r_idx){
+            row = row->next;
+            if(str8_compare(row_name, str8(row->name, char_length(row->name)))){
+                return(row->id);
             }
         }
     }
-    state = ParsingState_None;
+    return(ROW_HANDLE_NONE);
 }
 
 static void
-deserialize_data(void){
-    ScratchArena scratch = begin_scratch();
-    String8 full_path = str8_path_append(scratch.arena, saves_path, str8_literal("budget.b"));
+totals_row_spent(Row* row, u32 slot, s64 delta){
+    spend_tree_add(&row->spent_days, slot, delta);
+    if(row->counted){
+        spend_tree_add(&row->category->spent_days, slot, delta);
+        spend_tree_add(&pm->spent_days, slot, delta);
+    }
+}
 
-    File file = os_file_open(full_path, GENERIC_READ, OPEN_EXISTING);
-    if(!file.size){
-        //todo: log error
-        print("Error: file size 0, no data to load. <%s>\n", (char*)full_path.str);
-        os_file_close(file);
-        end_scratch(scratch);
+// note: a month with no unmuted transactions is muted, it has nothing spent and nothing planned
+static void
+totals_month_unmuted(MonthInfo* month, s32 delta){
+    month->unmuted_count += delta;
+    month->muted = !month->unmuted_count;
+}
+
+// note: takes out what the transaction's columns say it added, if it isn't muted
+static void
+totals_transaction_uncount(MonthInfo* month, u32 idx){
+    TransactionColumns* columns = &month->columns;
+    if(columns_muted(columns, idx)){
         return;
     }
+    Row* row = pm->row_handles[columns->row_ids[idx]];
+    if(row){
+        u32 slot = day_slot((u32)(month - pm->months), columns->date_keys[idx]);
+        totals_row_spent(row, slot, -columns->cents[idx]);
+    }
+    totals_month_unmuted(month, -1);
+    pm->totals_dirty = true;
+}
 
-    String8 data = os_file_read(scratch.arena, file);
-    String8* ptr = &data;
+// note: adds what the transaction's columns say, if it isn't muted
+static void
+totals_transaction_count(MonthInfo* month, u32 idx){
+    TransactionColumns* columns = &month->columns;
+    if(columns_muted(columns, idx)){
+        return;
+    }
+    Row* row = pm->row_handles[columns->row_ids[idx]];
+    if(row){
+        totals_row_spent(row, day_slot((u32)(month - pm->months), columns->date_keys[idx]), columns->cents[idx]);
+    }
+    totals_month_unmuted(month, 1);
+    pm->totals_dirty = true;
+}
 
-    s32 month_idx = 0;
-    state = ParsingState_None;
-    String8 line = {0};
-    while(ptr->size){
-        line = str8_eat_line(ptr);
+// note: to add a transaction or change its amount, date or row, false if a new one couldn't be stored and
+// isn't in the totals
+static bool
+totals_transaction_update(MonthInfo* month, Transaction* trans, s64 cents, u32 date_key, u32 row_id){
+    if(trans->column){
+        totals_transaction_uncount(month, trans->column - 1);
+    }
+    if(!columns_store(&month->columns, trans, cents, date_key, row_id)){
+        return(false);
+    }
+    totals_transaction_count(month, trans->column - 1);
+    return(true);
+}
+
+static void
+totals_transaction_mute(MonthInfo* month, Transaction* trans, bool muted){
+    if(trans->column){
+        totals_transaction_uncount(month, trans->column - 1);
+        columns_set_muted(&month->columns, trans->column - 1, muted);
+        totals_transaction_count(month, trans->column - 1);
+    }
+}
+
+// note: Mutes or unmutes every transaction of the month a word of bits at a time, only the transactions that
+// actually flip go through the totals.
+static void
+totals_month_mute(MonthInfo* month, bool muted){
+    TransactionColumns* columns = &month->columns;
+    for(u32 w_idx=0; w_idx < (columns->count + 63) / 64; ++w_idx){
+        u32 in_word = columns->count - w_idx * 64 < 64 ? columns->count - w_idx * 64 : 64;
+        u64 word = in_word == 64 ? ~(u64)0 : (((u64)1 << in_word) - 1);
+        u64 flips = muted ? (word & ~columns->muted[w_idx]) : columns->muted[w_idx];
+        if(muted){
+            for(u64 bits = flips; bits; bits &= bits - 1){
+                totals_transaction_uncount(month, w_idx * 64 + (u32)csv_lowest_bit(bits));
+            }
+            columns->muted[w_idx] |= word;
+        }
+        else{
+            columns->muted[w_idx] = 0;
+            for(u64 bits = flips; bits; bits &= bits - 1){
+                totals_transaction_count(month, w_idx * 64 + (u32)csv_lowest_bit(bits));
+            }
+        }
+    }
+}
+
+// note: before a transaction is freed
+static void
+totals_transaction_remove(MonthInfo* month, Transaction* trans){
+    if(trans->column){
+        totals_transaction_uncount(month, trans->column - 1);
+    }
+    columns_drop(&month->columns, trans);
+}
+
+static bool
+row_muted(Row* row){
+    bool result = (pm->rows_muted[row->id / 64] >> (row->id % 64)) & 1;
+    return(result);
+}
+
+// note: rows past the last handle can't be muted, bit 0 stays clear
+static void
+row_set_muted(Row* row, bool muted){
+    u64 bit = row->id ? (u64)1 << (row->id % 64) : 0;
+    pm->rows_muted[row->id / 64] = muted ? (pm->rows_muted[row->id / 64] | bit) : (pm->rows_muted[row->id / 64] & ~bit);
+}
+
+// note: a category is muted when all of its rows are, or it has none
+static bool
+category_muted(Category* category){
+    for(u32 w_idx=0; w_idx < array_count(category->row_bits); ++w_idx){
+        if(category->row_bits[w_idx] & ~pm->rows_muted[w_idx]){
+            return(false);
+        }
+    }
+    return(true);
+}
+
+// note: after a row was added or its planned or muted changed
+static void
+totals_row_update(Category* category, Row* row){
+    row->category = category;
+    category->row_bits[row->id / 64] |= row->id ? (u64)1 << (row->id % 64) : 0;
+    if(row->counted){
+        category->planned_cents -= row->planned_cents;
+        pm->planned_cents -= row->planned_cents;
+        spend_tree_merge(&category->spent_days, &row->spent_days, -1);
+        spend_tree_merge(&pm->spent_days, &row->spent_days, -1);
+    }
+
+    row->planned_cents = text_to_cents(row->planned);
+    row->counted = !row_muted(row);
+    if(row->counted){
+        category->planned_cents += row->planned_cents;
+        pm->planned_cents += row->planned_cents;
+        spend_tree_merge(&category->spent_days, &row->spent_days, 1);
+        spend_tree_merge(&pm->spent_days, &row->spent_days, 1);
+    }
+    pm->totals_dirty = true;
+}
+
+static void
+totals_row_mute(Row* row, bool muted){
+    row_set_muted(row, muted);
+    totals_row_update(row->category, row);
+}
+
+// note: flips the bits of every row of the category at once, only the rows that changed go through the totals
+static void
+totals_category_mute(Category* category, bool muted){
+    for(u32 w_idx=0; w_idx < array_count(category->row_bits); ++w_idx){
+        u64 flips = category->row_bits[w_idx] & (muted ? ~pm->rows_muted[w_idx] : pm->rows_muted[w_idx]);
+        pm->rows_muted[w_idx] ^= flips;
+        for(u64 bits = flips; bits; bits &= bits - 1){
+            Row* row = pm->row_handles[w_idx * 64 + csv_lowest_bit(bits)];
+            totals_row_update(category, row);
+        }
+    }
+}
+
+// note: Takes a row out of the totals before it's freed, its transactions are left without a row. Once the
+// row is muted its spending is only in its own tree, which goes with it, so the transactions just need
+// their handle cleared, nothing else in the totals changes.
+static void
+totals_row_remove(Category* category, Row* row){
+    totals_row_mute(row, true);
+    dll_remove(row);
+    --category->row_count;
+    --pm->total_rows_count;
+
+    for(u32 m_idx=0; row->id && m_idx < Month_Count; ++m_idx){
+        columns_clear_row(&pm->months[m_idx].columns, row->id);
+    }
+    category->row_bits[row->id / 64] &= ~((u64)1 << (row->id % 64));
+    row_set_muted(row, false);
+    row_handle_release(row);
+}
+
+// note: Everything from scratch, after loading. The sums are made from the columns alone: plain per slot cents
+// for each row, built into trees and merged upwards.
+static void
+totals_rebuild(void){
+    pm->planned_cents = 0;
+    pm->budget_cents = text_to_cents((char*)pm->budget.str);
+    memset(&pm->spent_days, 0, sizeof(pm->spent_days));
+
+    Category* category = pm->categories;
+    for(s32 c_idx = 0; c_idx < pm->categories_count; ++c_idx){
+        category = category->next;
+        category->planned_cents = 0;
+        memset(&category->spent_days, 0, sizeof(category->spent_days));
+
+        Row* row = category->rows;
+        for(s32 r_idx = 0; r_idx < category->row_count; ++r_idx){
+            row = row->next;
+            row->counted = false;
+            memset(&row->spent_days, 0, sizeof(row->spent_days));
+        }
+    }
+
+    for(u32 m_idx=0; m_idx < Month_Count; ++m_idx){
+        MonthInfo* month = pm->months + m_idx;
+        TransactionColumns* columns = &month->columns;
+        month->unmuted_count = columns_unmuted(columns);
+        month->muted = !month->unmuted_count;
+        columns_spend_days(m_idx, columns);
+    }
+
+    category = pm->categories;
+    for(s32 c_idx = 0; c_idx < pm->categories_count; ++c_idx){
+        category = category->next;
+
+        Row* row = category->rows;
+        for(s32 r_idx = 0; r_idx < category->row_count; ++r_idx){
+            row = row->next;
+            spend_tree_build(&row->spent_days);
+            totals_row_update(category, row);
+        }
+    }
+    pm->totals_dirty = true;
+}
+
+// note: How many months of planned and budget a range of slots is worth, muted months count for nothing and
+// a month the range only partly covers counts for the part it covers.
+static f64
+totals_range_months(u32 first, u32 end){
+    f64 result = 0;
+    for(u32 m_idx=0; m_idx < Month_Count; ++m_idx){
+        u32 month_first = month_first_slot[m_idx];
+        u32 month_end = month_first_slot[m_idx + 1];
+        u32 covered_first = first > month_first ? first : month_first;
+        u32 covered_end = end < month_end ? end : month_end;
+        if(!pm->months[m_idx].muted && covered_first < covered_end){
+            result += (f64)(covered_end - covered_first) / (f64)(month_end - month_first);
+        }
+    }
+    return(result);
+}
+
+// note: totals of any range of day slots [first, end), trailing days and custom quarters are just other ranges
+static Totals
+totals_range(u32 first, u32 end){
+    f64 months = totals_range_months(first, end);
+    f64 planned = (f64)pm->planned_cents * months;
+    f64 budget = (f64)pm->budget_cents * months;
+    f64 spent = (f64)spend_tree_range(&pm->spent_days, first, end);
+
+    Totals result = {0};
+    result.planned = (f32)(planned / 100.0);
+    result.spent   = (f32)(spent / 100.0);
+    result.diff    = (f32)((planned - spent) / 100.0);
+    result.saved   = (f32)((budget - spent) / 100.0);
+    result.goal    = (f32)((budget - planned) / 100.0);
+    return(result);
+}
+
+// note: the numbers the ui shows, rows and categories for the selected month. O(rows log n), never touches transactions.
+static void
+totals_refresh(void){
+    for(u32 m_idx=0; m_idx < Month_Count; ++m_idx){
+        pm->months[m_idx].totals = totals_range(month_first_slot[m_idx], month_first_slot[m_idx + 1]);
+    }
+    for(u32 q_idx=0; q_idx < array_count(pm->quarter_totals); ++q_idx){
+        pm->quarter_totals[q_idx] = totals_range(month_first_slot[q_idx * 3], month_first_slot[q_idx * 3 + 3]);
+    }
+    for(u32 b_idx=0; b_idx < array_count(pm->biannual_totals); ++b_idx){
+        pm->biannual_totals[b_idx] = totals_range(month_first_slot[b_idx * 6], month_first_slot[b_idx * 6 + 6]);
+    }
+    pm->annual_totals = totals_range(0, DAY_SLOTS);
+
+    u32 selected = (u32)(pm->month - pm->months);
+    u32 first = month_first_slot[selected];
+    u32 end = month_first_slot[selected + 1];
+    Category* category = pm->categories;
+    for(s32 c_idx = 0; c_idx < pm->categories_count; ++c_idx){
+        category = category->next;
+        s64 category_spent = spend_tree_range(&category->spent_days, first, end);
+        category->planned = cents_to_f32(category->planned_cents);
+        category->spent   = cents_to_f32(category_spent);
+        category->diff    = cents_to_f32(category->planned_cents - category_spent);
+
+        Row* row = category->rows;
+        for(s32 r_idx = 0; r_idx < category->row_count; ++r_idx){
+            row = row->next;
+            s64 row_spent = spend_tree_range(&row->spent_days, first, end);
+            row->spent = cents_to_f32(row_spent);
+            row->diff  = cents_to_f32(row->planned_cents - row_spent);
+        }
+    }
+
+    pm->totals_month = pm->month;
+    pm->totals_dirty = false;
+}
+
+typedef enum ParsingState{
+    ParsingState_None,
+    ParsingState_Budget,
+    ParsingState_Category,
+    ParsingState_Row,
+    ParsingState_Month,
+    ParsingState_Transaction,
+    ParsingState_Config,
+    ParsingState_Fingerprints,
+    ParsingState_LegacyFingerprints,
+    ParsingState_Watermarks,
+    ParsingState_Accounts,
+
+    ParsingState_Date,
+    ParsingState_Amount,
+    ParsingState_Description,
+
+    ParsingState_Count,
+} ParsingState;
+
+ParsingState state = ParsingState_None;
+
+static u64
+hash_mix(u64 x){
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return(x);
+}
+
+static bool
+fingerprint_set_contains(FingerprintSet* set, u64 fingerprint){
+    if(!set->capacity){
+        return(false);
+    }
+    u64 mask = set->capacity - 1;
+    for(u64 slot = fingerprint & mask; set->slots[slot]; slot = (slot + 1) & mask){
+        if(set->slots[slot] == fingerprint){
+            return(true);
+        }
+    }
+    return(false);
+}
+
+// note: false if the set had to grow and couldn't, it's left as it was
+static bool
+fingerprint_set_insert(FingerprintSet* set, u64 fingerprint){
+    if((set->count + 1) * 2 > set->capacity){
+        FingerprintSet grown = {0};
+        grown.capacity = set->capacity ? set->capacity * 2 : 1024;
+        grown.slots = (u64*)VirtualAlloc(0, grown.capacity * sizeof(u64), MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+        if(!grown.slots){
+            return(false);
+        }
+        for(u64 i=0; i < set->capacity; ++i){
+            if(set->slots[i]){
+                fingerprint_set_insert(&grown, set->slots[i]);
+            }
+        }
+        if(set->slots){
+            VirtualFree(set->slots, 0, MEM_RELEASE);
+        }
+        *set = grown;
+    }
+
+    u64 mask = set->capacity - 1;
+    u64 slot = fingerprint & mask;
+    for(; set->slots[slot]; slot = (slot + 1) & mask){
+        if(set->slots[slot] == fingerprint){
+            return(true);
+        }
+    }
+    set->slots[slot] = fingerprint;
+    ++set->count;
+    return(true);
+}
+
+// note: Every imported row is in pm->fingerprints twice: keyed on its account, and bare, which the same row
+// of any account matches. Rows of a file that didn't say which account it's from are keyed on
+// FINGERPRINT_NO_ACCOUNT.
+#define FINGERPRINT_NO_ACCOUNT 1
+static u64
+fingerprint_key(u64 fingerprint, u64 account){
+    u64 result = hash_mix(fingerprint ^ (account ? account : FINGERPRINT_NO_ACCOUNT)) | 1;
+    return(result);
+}
+
+// note: false if the set couldn't grow
+static bool
+fingerprint_set_insert_row(FingerprintSet* set, u64 fingerprint, u64 account){
+    bool result = (fingerprint_set_insert(set, fingerprint_key(fingerprint, account)) && fingerprint_set_insert(set, fingerprint));
+    return(result);
+}
+
+typedef enum ImportMatch{
+    ImportMatch_New,
+    ImportMatch_Duplicate, // note: the same account imported it before
+    ImportMatch_Ambiguous, // note: imported before, but one of the two didn't know its account, the user decides
+} ImportMatch;
+
+// note: A row of a known account only matches its own account's rows, the same row from another account is a
+// different transaction (both sides of a transfer). Without an account on either side there's no telling.
+static ImportMatch
+fingerprint_match(FingerprintSet* set, u64 fingerprint, u64 account){
+    if(account && fingerprint_set_contains(set, fingerprint_key(fingerprint, account))){
+        return(ImportMatch_Duplicate);
+    }
+    bool imported = account ? fingerprint_set_contains(set, fingerprint_key(fingerprint, 0)) : fingerprint_set_contains(set, fingerprint);
+    return(imported ? ImportMatch_Ambiguous : ImportMatch_New);
+}
+
+// note: the copy'th repeat of the same row in one file, see fingerprint_staged_rows()
+static u64
+fingerprint_copy(u64 fingerprint, u64 copy){
+    u64 result = copy ? (hash_mix(fingerprint + copy) | 1) : fingerprint;
+    return(result);
+}
+
+static void
+fingerprint_set_release(FingerprintSet* set){
+    if(set->slots){
+        VirtualFree(set->slots, 0, MEM_RELEASE);
+    }
+    *set = {0};
+}
+
+static Watermark*
+watermark_find(u64 source){
+    for(u32 i=0; i < pm->watermarks_count; ++i){
+        if(pm->watermarks[i].source == source){
+            return(pm->watermarks + i);
+        }
+    }
+    return(0);
+}
+
+// note: the updated watermark moves to the end, when full the least recently imported source is dropped
+static void
+watermark_set(Watermark* watermark){
+    Watermark* existing = watermark_find(watermark->source);
+    if(existing){
+        u32 idx = (u32)(existing - pm->watermarks);
+        memmove(existing, existing + 1, (pm->watermarks_count - idx - 1) * sizeof(Watermark));
+        --pm->watermarks_count;
+    }
+    else if(pm->watermarks_count == WATERMARK_MAX){
+        memmove(pm->watermarks, pm->watermarks + 1, (WATERMARK_MAX - 1) * sizeof(Watermark));
+        --pm->watermarks_count;
+    }
+    pm->watermarks[pm->watermarks_count++] = *watermark;
+}
+
+static ImportProfile*
+import_profile_find(u64 header){
+    for(u32 i=0; i < pm->profiles_count; ++i){
+        if(pm->profiles[i].header == header){
+            return(pm->profiles + i);
+        }
+    }
+    return(0);
+}
+
+// note: same as watermark_set(), the least recently learned header is dropped when full
+static void
+import_profile_set(ImportProfile* profile){
+    ImportProfile* existing = import_profile_find(profile->header);
+    if(existing){
+        u32 idx = (u32)(existing - pm->profiles);
+        memmove(existing, existing + 1, (pm->profiles_count - idx - 1) * sizeof(ImportProfile));
+        --pm->profiles_count;
+    }
+    else if(pm->profiles_count == IMPORT_PROFILE_MAX){
+        memmove(pm->profiles, pm->profiles + 1, (IMPORT_PROFILE_MAX - 1) * sizeof(ImportProfile));
+        --pm->profiles_count;
+    }
+    pm->profiles[pm->profiles_count++] = *profile;
+}
+
+static ImportAccount*
+import_account_find(u64 source){
+    for(u32 i=0; i < pm->accounts_count; ++i){
+        if(pm->accounts[i].source == source){
+            return(pm->accounts + i);
+        }
+    }
+    return(0);
+}
+
+// note: same as watermark_set(), the least recently imported source is dropped when full
+static void
+import_account_set(ImportAccount* account){
+    ImportAccount* existing = import_account_find(account->source);
+    if(existing){
+        u32 idx = (u32)(existing - pm->accounts);
+        memmove(existing, existing + 1, (pm->accounts_count - idx - 1) * sizeof(ImportAccount));
+        --pm->accounts_count;
+    }
+    else if(pm->accounts_count == IMPORT_ACCOUNT_MAX){
+        memmove(pm->accounts, pm->accounts + 1, (IMPORT_ACCOUNT_MAX - 1) * sizeof(ImportAccount));
+        --pm->accounts_count;
+    }
+    pm->accounts[pm->accounts_count++] = *account;
+}
+
+// note: What rows are fingerprinted with as their account, 0 for no name and never FINGERPRINT_NO_ACCOUNT.
+// Case and surrounding spaces don't count.
+static u64
+import_account_id(String8 name){
+    while(name.size && (name.str[0] == ' ' || name.str[0] == '\t')){
+        ++name.str;
+        --name.size;
+    }
+    while(name.size && (name.str[name.size - 1] == ' ' || name.str[name.size - 1] == '\t')){
+        --name.size;
+    }
+    u64 result = name.size ? (csv_alias_hash(name) | 2) : 0;
+    return(result);
+}
+
+// note: one profile per line, all hex: header date amount description columns delimiter quote decimal day_first
+static void
+save_profiles(void){
+    ScratchArena scratch = begin_scratch();
+    String8 full_path = str8_path_append(scratch.arena, build_path, str8_literal("profiles.conf"));
+
+    u64 size = KB(1) + pm->profiles_count * 96;
+    char* buffer = push_array(scratch.arena, char, size);
+    u64 at = snprintf(buffer, size, "# header date amount description columns delimiter quote decimal day_first\n");
+    for(u32 p_idx=0; p_idx < pm->profiles_count; ++p_idx){
+        ImportProfile* p = pm->profiles + p_idx;
+        at += snprintf(buffer + at, size - at, "%016llx %x %x %x %x %x %x %x %x\n", p->header,
+                       (u32)p->layout.date_idx, (u32)p->layout.amount_idx, (u32)p->layout.desc_idx, (u32)p->layout.column_count,
+                       p->dialect.delimiter, p->dialect.quote, p->dialect.decimal, (u32)p->dialect.day_first);
+    }
+
+    File file = os_file_open(full_path, GENERIC_WRITE, CREATE_ALWAYS);
+    if(file.handle != INVALID_HANDLE_VALUE){
+        os_file_write(file, (u8*)buffer, at);
+    }
+    else{
+        //todo: log error
+        print("Error: failed to open file <%s>\n", full_path.str);
+    }
+
+    os_file_close(file);
+    end_scratch(scratch);
+}
+
+// note: FNV-1a of the size source bytes before offset
+static u64
+watermark_anchor(MappedFile* mapped, u64 offset, u32 size){
+    String8 bytes = os_map_view(mapped, offset - size, size);
+    u64 hash = 0xcbf29ce484222325ull;
+    for(u64 i=0; i < bytes.size; ++i){
+        hash ^= bytes.str[i];
+        hash *= 0x100000001b3ull;
+    }
+    return(hash);
+}
+
+// note: Identifies a transaction across imports by date, cents and description, the account is added by
+// fingerprint_key(). Descriptions only count their letters and digits, case folded, so spacing and
+// punctuation differences between exports don't matter. Never 0, that's an empty slot.
+static u64
+fingerprint_transaction(char* description, u32 date_key, s64 cents){
+    u64 hash = 0xcbf29ce484222325ull;
+    for(char* c = description; *c; ++c){
+        u8 lower = csv_lower((u8)*c);
+        if((lower >= 'a' && lower <= 'z') || (lower >= '0' && lower <= '9') || lower >= 0x80){
+            hash ^= lower;
+            hash *= 0x100000001b3ull;
+        }
+    }
+    hash = hash_mix(hash ^ date_key);
+    hash = hash_mix(hash ^ (u64)cents);
+    return(hash | 1);
+}
+
+// note: Stable LSD radix sort of date keys, 8 bits a pass. order comes back as the indices of the keys in sorted
+// order, keys is overwritten. temp and temp_keys need room for count entries. Callers give transactions without
+// a date the key 0xFFFFFFFF, so they sort to the end and keep their order.
+static void
+radix_sort_dates(u32* keys, u32* order, u32* temp_keys, u32* temp, u32 count){
+    u32* src = order;
+    u32* dst = temp;
+
+    // note: histogram every digit in one pass
+    u32 histogram[4][256] = {0};
+    for(u32 i=0; i < count; ++i){
+        order[i] = i;
+        for(u32 pass=0; pass < 4; ++pass){
+            ++histogram[pass][(keys[i] >> (pass * 8)) & 0xFF];
+        }
+    }
+
+    for(u32 pass=0; pass < 4; ++pass){
+        u32 shift = pass * 8;
+
+        // note: every key has the same digit, nothing to do this pass
+        if(histogram[pass][(keys[0] >> shift) & 0xFF] == count){
+            continue;
+        }
+
+        u32 offsets[256];
+        u32 total = 0;
+        for(u32 digit=0; digit < 256; ++digit){
+            offsets[digit] = total;
+            total += histogram[pass][digit];
+        }
+        for(u32 i=0; i < count; ++i){
+            u32 at = offsets[(keys[i] >> shift) & 0xFF]++;
+            dst[at] = src[i];
+            temp_keys[at] = keys[i];
+        }
+
+        u32* temp_order = src; src = dst; dst = temp_order;
+        u32* swap_keys = keys; keys = temp_keys; temp_keys = swap_keys;
+    }
+
+    if(src != order){
+        memcpy(order, src, count * sizeof(u32));
+    }
+}
+
+// note: Parsed row of one file waiting to be committed. Its text is parsed straight into the transaction it
+// becomes, so every field is copied once, out of the file. A row that isn't committed hands it back.
+typedef struct StagedRow{
+    Transaction* trans;
+    s64 cents;
+    u64 fingerprint;
+    u32 date_key;
+} StagedRow;
+
+// note: Parsed rows of one file waiting to be committed, about one block per window. Every row up to capacity
+// gets its transaction when the block is made, one lock for the whole block.
+typedef struct StagedBlock{
+    StagedBlock* next;
+    StagedRow* rows;
+    u64 count;
+    u64 capacity;
+} StagedBlock;
+
+#define STAGED_BLOCK_ROWS 4096 // note: for the importers that don't know how many rows a window holds
+
+// note: One file of an import. Parsing only fills in staged blocks and never touches pm, so files can be
+// parsed on any thread and all of them are committed to the months together afterwards.
+typedef struct ImportFile{
+    String8 path;
+    u64 size;
+    volatile u64 bytes_done; // note: written by the parsing thread, read for progress
+
+    StagedBlock* first;
+    StagedBlock* last;
+    u64 row_count;       // note: rows parsed, duplicates included
+    u64 duplicate_count; // note: rows dropped since pm->fingerprints had them, see fingerprint_staged_rows()
+
+    // note: where fingerprint_staged_rows() got to, and the fingerprints of the rows it's been through
+    StagedBlock* fingerprinted;
+    u64 fingerprinted_count;
+    FingerprintSet seen;
+
+    Watermark watermark; // note: csv only, saved when the import is committed, source 0 if there's none
+    bool resumed;        // note: only the tail after the last imports watermark was parsed
+    u64 account;         // note: see import_account_id(), 0 if the file doesn't say and none was named
+    volatile bool* cancel;
+
+    // note: csv only, where the parse is. A preview sets prepared so the import carries on from offset.
+    bool prepared;
+    CSVLayout layout;
+    CSVDialect dialect;
+    bool profiled;  // note: layout and dialect came from a profile instead of the header
+    u64 header;     // note: see ImportProfile
+    u64 source;     // note: hash of the path, what watermarks and accounts are remembered by
+    char account_name[64]; // note: as named in the preview, or remembered for source
+    u64 body_offset;
+    u64 offset;
+    u32 worker_count; // note: chunk workers per window, see import_job_proc()
+
+    f64 seconds;
+    volatile bool done;
+    bool failed;
+    bool full; // note: failed since there was no room for its transactions
+} ImportFile;
+
+typedef struct ImportBatch{
+    ImportFile* files;
+    u32 file_count;
+    volatile LONG next_file;
+} ImportBatch;
+
+// note: New transactions of one month, sorted by date, as a chain and the columns that go with it. The import
+// thread builds both, publishing only splices the chain on and hands the columns over, see import_publish().
+// The transactions' column indices are into these columns until then.
+typedef struct ImportMonth{
+    Transaction* first;
+    Transaction* last;
+    TransactionColumns columns;
+} ImportMonth;
+
+// note: A staged row that might have been imported before, see ImportMatch_Ambiguous. It's in the months like
+// the others until the user decides, m_idx is the month it went to.
+typedef struct ImportAmbiguous{
+    Transaction* trans;
+    u32 m_idx;
+} ImportAmbiguous;
+
+#define IMPORT_MAX_FILES 4096
+
+// note: The import running in the background. The main thread owns it until import_start() and again once
+// finished is set, the import thread owns it in between except for cancel and the files progress.
+typedef struct ImportJob{
+    ImportBatch batch;
+    Arena* arena; // note: files and their paths, reset for every import
+    HANDLE thread;
+    u32 month_idx; // note: where rows without a date go
+    u64 start;
+
+    ImportMonth months[Month_Count];
+    FingerprintSet fingerprints; // note: pm->fingerprints plus the new rows, replaces it when published
+    u64 row_count;
+    u64 duplicate_count;
+    f64 seconds;
+
+    // note: the import isn't published until the main thread decides what happens to these
+    ImportAmbiguous* ambiguous;
+    u64 ambiguous_count;
+    u64 ambiguous_capacity;
+    bool ambiguous_decided;
+    bool ambiguous_skipped;
+
+    bool active;
+    bool failed;
+    bool full; // note: parsed, but there wasn't room for the transactions
+    bool staged;
+    volatile bool cancel;
+    volatile bool finished;
+} ImportJob;
+
+static ImportJob import_job;
+
+static bool
+import_cancelled(ImportFile* file){
+    bool result = (file->cancel && *file->cancel);
+    return(result);
+}
+
+// note: A file that can't get memory for its rows fails, and with it the batch. The block is linked even
+// then, release_import() hands back whatever transactions it did get.
+static StagedBlock*
+stage_block(ImportFile* file, u64 capacity){
+    StagedBlock* block = (StagedBlock*)VirtualAlloc(0, sizeof(StagedBlock) + capacity * sizeof(StagedRow), MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+    if(!block){
+        file->failed = true;
+        file->full = true;
+        return(0);
+    }
+    block->rows = (StagedRow*)(block + 1);
+    block->capacity = capacity;
+    if(file->last){
+        file->last->next = block;
+    }
+    else{
+        file->first = block;
+    }
+    file->last = block;
+
+    AcquireSRWLockExclusive(&pm->transaction_lock);
+    for(u64 row_idx=0; row_idx < capacity; ++row_idx){
+        block->rows[row_idx].trans = transaction_alloc(&pm->transactions);
+        if(!block->rows[row_idx].trans){
+            file->failed = true;
+            file->full = true;
+            break;
+        }
+    }
+    ReleaseSRWLockExclusive(&pm->transaction_lock);
+    return(file->failed ? 0 : block);
+}
+
+// note: Starts a new block of capacity rows when the last one is full. The row's text is written straight
+// into row->trans. Returns 0 if the file failed, see stage_block().
+static StagedRow*
+stage_row(ImportFile* file, u64 capacity){
+    StagedBlock* block = file->last;
+    if(!block || block->count == block->capacity){
+        block = stage_block(file, capacity);
+        if(!block){
+            return(0);
+        }
+    }
+    StagedRow* result = block->rows + block->count++;
+    ++file->row_count;
+    return(result);
+}
+
+// note: takes back the last staged row, its transaction is cleared for the next one
+static void
+unstage_row(ImportFile* file){
+    StagedBlock* block = file->last;
+    StagedRow* row = block->rows + --block->count;
+    --file->row_count;
+    Transaction* trans = row->trans;
+    memset(trans, 0, sizeof(Transaction));
+    *row = {0};
+    row->trans = trans;
+}
+
+// note: after a file is fingerprinted, the transactions its blocks didn't use go back to the store
+static void
+stage_finish(ImportFile* file){
+    AcquireSRWLockExclusive(&pm->transaction_lock);
+    for(StagedBlock* block = file->first; block; block = block->next){
+        for(u64 row_idx=block->count; row_idx < block->capacity; ++row_idx){
+            if(block->rows[row_idx].trans){
+                transaction_free(&pm->transactions, block->rows[row_idx].trans);
+                block->rows[row_idx].trans = 0;
+            }
+        }
+        block->capacity = block->count;
+    }
+    ReleaseSRWLockExclusive(&pm->transaction_lock);
+    fingerprint_set_release(&file->seen);
+}
+
+// note: Fingerprints the rows staged since the last call. Rows that really are identical (two coffees on the
+// same day) are told apart by how many came before them in the file, the nth copy gets the nth fingerprint.
+// Reimporting the same statement produces the same fingerprints again. Rows the importer already fingerprinted
+// are left alone, and the file fails if there's no memory to tell copies apart.
+// A resumed file only has its tail, the copies before the watermark are already in pm->fingerprints so they
+// are counted from there. pm isn't written while files are parsing.
+// Rows that pm->fingerprints has for the file's account are dropped on the spot, see fingerprint_match(). Their transactions are cleared and kept past the
+// end of their block, where the next rows staged into it reuse them, so csv files, which are fingerprinted
+// after every window, only take transactions for what's new.
+static void
+fingerprint_staged_rows(ImportFile* file){
+    StagedBlock* block = file->fingerprinted ? file->fingerprinted : file->first;
+    u64 row_idx = file->fingerprinted ? file->fingerprinted_count : 0;
+    for(; block && !file->failed; block = block->next, row_idx = 0){
+        u64 kept = row_idx;
+        for(; row_idx < block->count; ++row_idx){
+            StagedRow* row = block->rows + row_idx;
+            if(!row->fingerprint){
+                u64 base = fingerprint_transaction(row->trans->description, row->date_key, row->cents);
+                u64 fingerprint = base;
+                for(u64 copy=1; fingerprint_set_contains(&file->seen, fingerprint) ||
+                                (file->resumed && fingerprint_set_contains(&pm->fingerprints, fingerprint_key(fingerprint, file->account))); ++copy){
+                    fingerprint = fingerprint_copy(base, copy);
+                }
+                if(!fingerprint_set_insert(&file->seen, fingerprint)){
+                    file->failed = true;
+                    break;
+                }
+                row->fingerprint = fingerprint;
+            }
+            if(fingerprint_match(&pm->fingerprints, row->fingerprint, file->account) == ImportMatch_Duplicate){
+                memset(row->trans, 0, sizeof(Transaction));
+                ++file->duplicate_count;
+                continue;
+            }
+            StagedRow swap = block->rows[kept];
+            block->rows[kept++] = *row;
+            *row = swap;
+        }
+        if(file->failed){
+            break;
+        }
+
+        for(u64 spare_idx=kept; spare_idx < block->count; ++spare_idx){
+            StagedRow* spare = block->rows + spare_idx;
+            Transaction* trans = spare->trans;
+            *spare = {0};
+            spare->trans = trans;
+        }
+        block->count = kept;
+        file->fingerprinted = block;
+        file->fingerprinted_count = kept;
+    }
+}
+
+#define IMPORT_PREVIEW_SIZE KB(4)
+#define IMPORT_PREVIEW_ROWS 20
+#define IMPORT_PREVIEW_COLUMNS CSV_HEADER_COLUMNS
+
+// note: A csv file parsed up to the end of its first small window, shown before anything is imported.
+// Confirming hands file and its staged rows to an import that carries on at file.offset.
+typedef struct ImportPreview{
+    ImportFile file;
+    char path[1024];
+    char columns[IMPORT_PREVIEW_COLUMNS][64];
+    CSVRole roles[IMPORT_PREVIEW_COLUMNS];
+    u32 column_count;
+    f64 seconds;
+    const char* error; // note: why the last confirm didn't start an import
+    bool open;
+} ImportPreview;
+
+static ImportPreview import_preview;
+
+// note: Resolves the header and where the body starts, after the header or at the watermark. The header
+// names are copied into preview when there is one.
+static void
+csv_prepare_import(ImportFile* file, MappedFile* mapped, CSVReader* reader, u64 data_start, ImportPreview* preview){
+    bool final = false;
+    String8 window = csv_reader_window(reader, data_start, CSV_SNIFF_SIZE, &final);
+
+    // note: A header seen before skips sniffing and alias matching, its profile says how the file reads.
+    // The profile path ends the header at its first line break, which is where the scanner ends it too
+    // unless a name has a line break in quotes, and then the hash just doesn't match a profile.
+    // Previews always resolve the header, they show the column names.
+    ImportProfile* profile = 0;
+    u64 header_size = 0;
+    if(!preview){
+        header_size = csv_header_line_size(window);
+        if(header_size){
+            profile = import_profile_find(csv_alias_hash(str8(window.str, header_size)));
+        }
+    }
+
+    CSVDialect dialect;
+    CSVLayout layout;
+    if(profile){
+        dialect = profile->dialect;
+        layout = profile->layout;
+        file->profiled = true;
+    }
+    else{
+        // note: the names are views into the window
+        CSVHeader header = csv_resolve_header(window, &pm->header_aliases);
+        dialect = header.dialect;
+        layout = header.layout;
+        header_size = header.size;
+        for(u32 c_idx=0; preview && c_idx < header.name_count; ++c_idx){
+            csv_copy_field(preview->columns[c_idx], sizeof(preview->columns[c_idx]), header.names[c_idx]);
+            preview->roles[c_idx] = header.roles[c_idx];
+            preview->column_count = c_idx + 1;
+        }
+    }
+    file->header = csv_alias_hash(str8(window.str, header_size));
+    file->body_offset = data_start + csv_reader_source_size(reader, header_size);
+    file->offset = file->body_offset;
+    file->layout = layout;
+    file->dialect = dialect;
+    file->prepared = true;
+
+    // note: Banks export cumulative statements that grow at the end, so a file whose last imported record is
+    // still where it was only has its tail parsed. If it moved (old rows dropped, the file was edited) the
+    // whole file is parsed again and fingerprints skip what was already imported.
+    file->source = csv_alias_hash(file->path);
+    file->watermark.source = file->source;
+
+    // note: a preview shows the remembered account and can change it before anything is fingerprinted
+    ImportAccount* account = import_account_find(file->source);
+    if(account){
+        memcpy(file->account_name, account->name, sizeof(file->account_name));
+        file->account = import_account_id(str8(file->account_name, char_length(file->account_name)));
+    }
+    Watermark* watermark = watermark_find(file->watermark.source);
+    if(watermark && watermark->offset > file->body_offset && watermark->offset <= mapped->file.size &&
+       watermark->anchor == watermark_anchor(mapped, watermark->offset, watermark->anchor_size)){
+        file->offset = watermark->offset;
+        file->resumed = true;
+    }
+}
+
+// note: Stages the records of the window csv_next_window() parsed. The rows' text is copied out of the window
+// into their transactions here, nothing else keeps a view into it.
+static void
+csv_stage_window(ImportFile* file, CSVWindows* windows){
+    CSVDialect dialect = file->dialect;
+    CSVParse* parse = &windows->parse;
+
+    // note: chunks are copied in order so transactions keep their file order
+    u64 remaining = parse->record_count;
+    for(u32 chunk_idx=0; chunk_idx < parse->chunk_count && !file->failed; ++chunk_idx){
+        CSVChunk* chunk = parse->chunks + chunk_idx;
+        for(u64 record_idx=0; record_idx < chunk->record_count; ++record_idx, --remaining){
+            CSVRecord* record = chunk->records + record_idx;
+            StagedRow* row = stage_row(file, remaining);
+            if(!row){
+                break;
+            }
+            Transaction* trans = row->trans;
+            row->date_key = record->date_key;
+            row->cents = record->cents;
+
+            // note: budget.b and the inputs use M/D/Y and '.', rewrite the text of other dialects
+            char text[32];
+            String8 date = record->date;
+            String8 amount = record->amount;
+            if(dialect.day_first && row->date_key){
+                u32 key = row->date_key;
+                date = str8(text, (u64)snprintf(text, sizeof(text), "%02u/%02u/%04u", date_key_month(key), key & 0x1F, key >> 9));
+            }
+            csv_copy_field(trans->date, sizeof(trans->date), date);
+            if(dialect.decimal != '.'){
+                amount = str8(text, (u64)snprintf(text, sizeof(text), "%lld.%02lld", row->cents / 100, row->cents % 100));
+            }
+            csv_copy_field(trans->amount, sizeof(trans->amount), amount);
+            csv_copy_field(trans->description, sizeof(trans->description), record->description);
+        }
+    }
+}
+
+static void
+parse_csv_file(ImportFile* file){
+    u64 start = clock.get_os_timer();
+
+    MappedFile mapped = os_open_mapping(file->path);
+    if(!mapped.mapping){
+        //todo: log error
+        print("Error: failed to open file <%s>\n", file->path.str);
+        os_close_mapping(&mapped);
+        file->failed = true;
+        file->done = true;
+        return;
+    }
+    file->size = mapped.file.size;
+    begin_timed_bandwidth("parse_csv_file", mapped.file.size);
+
+    // note: The file is walked in fixed size windows of the mapping, only one window is mapped at a time
+    // and its records are copied out before the next one is mapped, so memory stays constant however big
+    // the file is. Files that aren't utf-8 are transcoded one window at a time on the way in.
+    u64 window_size = CSV_WINDOW_SIZE * (file->worker_count ? file->worker_count : 1);
+    u64 data_start = 0;
+    CSVReader reader = csv_reader(&mapped, &data_start);
+    if(!file->prepared){
+        csv_prepare_import(file, &mapped, &reader, data_start, 0);
+    }
+
+    CSVWindows windows = csv_windows(&reader, file->offset, window_size, file->layout, file->dialect, file->worker_count);
+    while(!import_cancelled(file) && !file->failed && csv_next_window(&windows)){
+        csv_stage_window(file, &windows);
+        csv_window_done(&windows);
+        fingerprint_staged_rows(file);
+        file->offset = windows.offset;
+        file->bytes_done = file->offset;
+    }
+
+    // note: a last line without its newline could still grow, the file only gets a watermark if it ends a line
+    u64 offset = file->offset;
+    file->watermark.offset = 0;
+    if(offset >= file->body_offset + 2){
+        String8 last = os_map_view(&mapped, offset - 2, 2);
+        if(last.size == 2 && (last.str[0] == '\n' || last.str[1] == '\n')){
+            u64 anchor_size = offset - file->body_offset;
+            file->watermark.anchor_size = (u32)(anchor_size < WATERMARK_ANCHOR_SIZE ? anchor_size : WATERMARK_ANCHOR_SIZE);
+            file->watermark.anchor = watermark_anchor(&mapped, offset, file->watermark.anchor_size);
+            file->watermark.offset = offset;
+        }
+    }
+    if(!file->watermark.offset){
+        file->watermark.source = 0;
+    }
+
+    csv_reader_release(&reader);
+    os_close_mapping(&mapped);
+
+    stage_finish(file);
+    file->seconds = clock.get_seconds_elapsed(clock.get_os_timer(), start);
+    file->done = true;
+}
+
+// note: Same windows as parse_csv_file, one pass, no tree. A STMTTRN's elements are copied into its staged row as
+// they arrive, so nothing outlives the window it came from. Rows are fingerprinted
+// on their FITID, the banks own id, when the file has one, and on the ACCTID as their account.
+static void
+parse_ofx_file(ImportFile* file){
+    u64 start = clock.get_os_timer();
+
+    MappedFile mapped = os_open_mapping(file->path);
+    if(!mapped.mapping){
+        //todo: log error
+        print("Error: failed to open file <%s>\n", file->path.str);
+        os_close_mapping(&mapped);
+        file->failed = true;
+        file->done = true;
+        return;
+    }
+    file->size = mapped.file.size;
+    begin_timed_bandwidth("parse_ofx_file", mapped.file.size);
+
+    u64 window_size = CSV_WINDOW_SIZE;
+    u64 offset = 0;
+    CSVReader reader = csv_reader(&mapped, &offset);
+    bool final = false;
+    if(reader.encoding == CSVEncoding_UTF8){
+        String8 head = csv_reader_window(&reader, offset, KB(4), &final);
+        reader.encoding = ofx_header_encoding(head, reader.encoding);
+    }
+
+    StagedRow* row = 0; // note: while inside a STMTTRN
+    u64 fitid = 0;
+    while(offset < mapped.file.size && !import_cancelled(file) && !file->failed){
+        String8 window = csv_reader_window(&reader, offset, window_size, &final);
+        if(!window.size){
+            break;
+        }
+
+        OFXTokenizer tokenizer = ofx_tokenizer(window, final);
+        OFXToken token;
+        while(ofx_next_token(&tokenizer, &token)){
+            if(token.type == OFXTokenType_Close){
+                if(row && str8_compare(token.name, str8_literal("STMTTRN"))){
+                    if(fitid){
+                        row->fingerprint = hash_mix(fitid) | 1;
+                    }
+                    row = 0;
+                }
+                continue;
+            }
+
+            // note: A row is staged when its STMTTRN opens and its elements are written into it, so a file cut
+            // off inside its last STMTTRN still gets what it had of it. One left open by the next is dropped.
+            if(str8_compare(token.name, str8_literal("STMTTRN"))){
+                if(row){
+                    unstage_row(file);
+                }
+                row = stage_row(file, STAGED_BLOCK_ROWS);
+                if(!row){
+                    break;
+                }
+                fitid = 0;
+            }
+            else if(str8_compare(token.name, str8_literal("ACCTID"))){
+                file->account = import_account_id(token.value);
+            }
+            else if(!row){
+                continue;
+            }
+            else if(str8_compare(token.name, str8_literal("DTPOSTED"))){
+                row->date_key = ofx_parse_date(token.value);
+                if(row->date_key){
+                    u32 key = row->date_key;
+                    snprintf(row->trans->date, sizeof(row->trans->date), "%02u/%02u/%04u", date_key_month(key), key & 0x1F, key >> 9);
+                }
+            }
+            else if(str8_compare(token.name, str8_literal("TRNAMT"))){
+                // note: shown as spent like csv imports, debits drop their sign
+                row->cents = csv_parse_amount(token.value, '.');
+                if(row->cents < 0){
+                    row->cents = -row->cents;
+                }
+                snprintf(row->trans->amount, sizeof(row->trans->amount), "%lld.%02lld", row->cents / 100, row->cents % 100);
+            }
+            else if(str8_compare(token.name, str8_literal("NAME"))){
+                ofx_copy_value(row->trans->description, sizeof(row->trans->description), token.value);
+            }
+            else if(str8_compare(token.name, str8_literal("MEMO")) && !row->trans->description[0]){
+                ofx_copy_value(row->trans->description, sizeof(row->trans->description), token.value);
+            }
+            else if(str8_compare(token.name, str8_literal("FITID"))){
+                fitid = csv_alias_hash(token.value);
+            }
+        }
+
+        // note: a single token bigger than the window, grow the window until it fits
+        if(!tokenizer.at){
+            window_size *= 2;
+        }
+        offset += csv_reader_source_size(&reader, tokenizer.at);
+        file->bytes_done = offset;
+    }
+
+    csv_reader_release(&reader);
+    os_close_mapping(&mapped);
+
+    fingerprint_staged_rows(file);
+    stage_finish(file);
+    file->seconds = clock.get_seconds_elapsed(clock.get_os_timer(), start);
+    file->done = true;
+}
+
+// note: Same windows as parse_csv_file, one pass. A record is staged on its first line and filled in as the
+// rest arrive, so records can straddle windows. It's kept when its ^ is reached. Only bank, cash and card blocks are imported, split
+// lines are skipped since T is already the total.
+static void
+parse_qif_file(ImportFile* file){
+    u64 start = clock.get_os_timer();
+
+    MappedFile mapped = os_open_mapping(file->path);
+    if(!mapped.mapping){
+        //todo: log error
+        print("Error: failed to open file <%s>\n", file->path.str);
+        os_close_mapping(&mapped);
+        file->failed = true;
+        file->done = true;
+        return;
+    }
+    file->size = mapped.file.size;
+    begin_timed_bandwidth("parse_qif_file", mapped.file.size);
+
+    u64 window_size = CSV_WINDOW_SIZE;
+    u64 offset = 0;
+    CSVReader reader = csv_reader(&mapped, &offset);
+    bool final = false;
+
+    QIFBlock block = QIFBlock_None;
+    StagedRow* row = 0; // note: the record being read
+    bool has_total = false;
+    while(offset < mapped.file.size && !import_cancelled(file) && !file->failed){
+        String8 window = csv_reader_window(&reader, offset, window_size, &final);
+        if(!window.size){
+            break;
+        }
+
+        QIFLines lines = qif_lines(window, final);
+        String8 line;
+        while(!file->failed && qif_next_line(&lines, &line)){
+            if(!line.size){
+                continue;
+            }
+            u8 field = line.str[0];
+            String8 value = str8(line.str + 1, line.size - 1);
+
+            if(field == '!'){
+                block = qif_block(line, block);
+                if(row){
+                    unstage_row(file);
+                    row = 0;
+                }
+                has_total = false;
+                continue;
+            }
+
+            if(block == QIFBlock_Account){
+                // note: a file can hold several accounts, rows are fingerprinted on the first one named
+                if(field == 'N' && !file->account){
+                    file->account = import_account_id(value);
+                }
+                continue;
+            }
+            if(block != QIFBlock_Transactions){
+                continue;
+            }
+
+            bool record_field = (field == 'D' || field == 'T' || field == 'U' || field == 'P' || field == 'M' || field == 'L');
+            if(record_field && !row){
+                row = stage_row(file, STAGED_BLOCK_ROWS);
+                if(!row){
+                    break;
+                }
+            }
+
+            switch(field){
+                case 'D':{
+                    row->date_key = qif_parse_date(value);
+                    if(row->date_key){
+                        u32 key = row->date_key;
+                        snprintf(row->trans->date, sizeof(row->trans->date), "%02u/%02u/%04u", date_key_month(key), key & 0x1F, key >> 9);
+                    }
+                } break;
+                case 'T':
+                case 'U':{
+                    // note: U is the same amount written by newer Quicken, T wins when both are there
+                    if(field == 'T' || !has_total){
+                        // note: shown as spent like csv imports, debits drop their sign
+                        row->cents = csv_parse_amount(value, '.');
+                        if(row->cents < 0){
+                            row->cents = -row->cents;
+                        }
+                        snprintf(row->trans->amount, sizeof(row->trans->amount), "%lld.%02lld", row->cents / 100, row->cents % 100);
+                        has_total = (field == 'T');
+                    }
+                } break;
+                case 'P':{
+                    csv_copy_field(row->trans->description, sizeof(row->trans->description), value);
+                } break;
+                case 'M':
+                case 'L':{
+                    // note: memo, then category, stand in for a missing payee. P can still come after and replace them.
+                    if(!row->trans->description[0]){
+                        csv_copy_field(row->trans->description, sizeof(row->trans->description), value);
+                    }
+                } break;
+                case '^':{
+                    row = 0;
+                    has_total = false;
+                } break;
+            }
+        }
+
+        // note: a single line bigger than the window, grow the window until it fits
+        if(!lines.at){
+            window_size *= 2;
+        }
+        offset += csv_reader_source_size(&reader, lines.at);
+        file->bytes_done = offset;
+    }
+
+    // note: a record without its ^ is dropped
+    if(row){
+        unstage_row(file);
+    }
+    csv_reader_release(&reader);
+    os_close_mapping(&mapped);
+
+    fingerprint_staged_rows(file);
+    stage_finish(file);
+    file->seconds = clock.get_seconds_elapsed(clock.get_os_timer(), start);
+    file->done = true;
+}
+
+static bool
+is_ofx_path(String8 path){
+    String8 extension = str8_path_extension(path);
+    bool result = (str8_compare_nocase(extension, str8_literal(".ofx")) || str8_compare_nocase(extension, str8_literal(".qfx")));
+    return(result);
+}
+
+static bool
+is_qif_path(String8 path){
+    bool result = str8_compare_nocase(str8_path_extension(path), str8_literal(".qif"));
+    return(result);
+}
+
+static bool
+is_csv_path(String8 path){
+    bool result = str8_compare_nocase(str8_path_extension(path), str8_literal(".csv"));
+    return(result);
+}
+
+static bool
+is_statement_path(String8 path){
+    bool result = (is_ofx_path(path) || is_qif_path(path) || is_csv_path(path));
+    return(result);
+}
+
+static void
+parse_import_file(ImportFile* file){
+    if(is_ofx_path(file->path)){
+        parse_ofx_file(file);
+    }
+    else if(is_qif_path(file->path)){
+        parse_qif_file(file);
+    }
+    else{
+        parse_csv_file(file);
+    }
+}
+
+// note: the transactions of rows that weren't committed go back to the store with their blocks
+static void
+release_import(ImportFile* files, u32 file_count){
+    for(u32 file_idx=0; file_idx < file_count; ++file_idx){
+        StagedBlock* block = files[file_idx].first;
+        while(block){
+            StagedBlock* next = block->next;
+            AcquireSRWLockExclusive(&pm->transaction_lock);
+            for(u64 row_idx=0; row_idx < block->capacity; ++row_idx){
+                if(block->rows[row_idx].trans){
+                    transaction_free(&pm->transactions, block->rows[row_idx].trans);
+                }
+            }
+            ReleaseSRWLockExclusive(&pm->transaction_lock);
+            VirtualFree(block, 0, MEM_RELEASE);
+            block = next;
+        }
+        files[file_idx].first = 0;
+        files[file_idx].last = 0;
+        fingerprint_set_release(&files[file_idx].seen);
+    }
+}
+
+static DWORD WINAPI
+import_worker_proc(LPVOID param){
+    ImportBatch* batch = (ImportBatch*)param;
+    for(;;){
+        LONG file_idx = InterlockedIncrement(&batch->next_file) - 1;
+        if(file_idx >= (LONG)batch->file_count){
+            break;
+        }
+        ImportFile* file = batch->files + file_idx;
+        if(import_cancelled(file)){
+            file->done = true;
+            continue;
+        }
+        parse_import_file(file);
+    }
+    return(0);
+}
+
+static bool
+fingerprint_set_copy(FingerprintSet* dst, FingerprintSet* src){
+    *dst = *src;
+    if(src->capacity){
+        dst->slots = (u64*)VirtualAlloc(0, src->capacity * sizeof(u64), MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+        if(!dst->slots){
+            *dst = {0};
+            return(false);
+        }
+        memcpy(dst->slots, src->slots, src->capacity * sizeof(u64));
+    }
+    return(true);
+}
+
+static void
+import_ambiguous_release(ImportJob* job){
+    if(job->ambiguous){
+        VirtualFree(job->ambiguous, 0, MEM_RELEASE);
+    }
+    job->ambiguous = 0;
+    job->ambiguous_count = 0;
+    job->ambiguous_capacity = 0;
+}
+
+// note: hands the transactions of an import that won't be published back to the store
+static void
+import_months_release(ImportJob* job){
+    AcquireSRWLockExclusive(&pm->transaction_lock);
+    for(u32 m_idx=0; m_idx < Month_Count; ++m_idx){
+        ImportMonth* month = job->months + m_idx;
+        for(u32 idx=0; idx < month->columns.count; ++idx){
+            transaction_free(&pm->transactions, month->columns.nodes[idx]);
+        }
+        columns_release(&month->columns);
+        *month = {0};
+    }
+    ReleaseSRWLockExclusive(&pm->transaction_lock);
+    fingerprint_set_release(&job->fingerprints);
+    import_ambiguous_release(job);
+}
+
+// note: false if the list couldn't grow, it's left as it was
+static bool
+import_ambiguous_add(ImportJob* job, Transaction* trans, u32 m_idx){
+    if(job->ambiguous_count == job->ambiguous_capacity){
+        u64 capacity = job->ambiguous_capacity ? job->ambiguous_capacity * 2 : 256;
+        ImportAmbiguous* grown = (ImportAmbiguous*)VirtualAlloc(0, capacity * sizeof(ImportAmbiguous), MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+        if(!grown){
+            return(false);
+        }
+        if(job->ambiguous){
+            memcpy(grown, job->ambiguous, job->ambiguous_count * sizeof(ImportAmbiguous));
+            VirtualFree(job->ambiguous, 0, MEM_RELEASE);
+        }
+        job->ambiguous = grown;
+        job->ambiguous_capacity = capacity;
+    }
+    job->ambiguous[job->ambiguous_count++] = {trans, m_idx};
+    return(true);
+}
+
+// note: chains the month's transactions in column order and points them at their columns
+static void
+import_month_chain(ImportMonth* month){
+    TransactionColumns* columns = &month->columns;
+    for(u32 idx=0; idx < columns->count; ++idx){
+        Transaction* trans = columns->nodes[idx];
+        trans->column = idx + 1;
+        trans->prev = idx ? columns->nodes[idx - 1] : 0;
+        trans->next = idx + 1 < columns->count ? columns->nodes[idx + 1] : 0;
+    }
+    month->first = columns->count ? columns->nodes[0] : 0;
+    month->last = columns->count ? columns->nodes[columns->count - 1] : 0;
+}
+
+// note: Takes the ambiguous rows the user skipped back out of the staged months, the rest keep their order.
+// Their fingerprints stay in the new set next to the rows they matched.
+static void
+import_months_skip(ImportJob* job){
+    AcquireSRWLockExclusive(&pm->transaction_lock);
+    for(u64 a_idx=0; a_idx < job->ambiguous_count; ++a_idx){
+        ImportAmbiguous* ambiguous = job->ambiguous + a_idx;
+        job->months[ambiguous->m_idx].columns.nodes[ambiguous->trans->column - 1] = 0;
+        transaction_free(&pm->transactions, ambiguous->trans);
+    }
+    ReleaseSRWLockExclusive(&pm->transaction_lock);
+
+    for(u32 m_idx=0; m_idx < Month_Count; ++m_idx){
+        ImportMonth* month = job->months + m_idx;
+        TransactionColumns* columns = &month->columns;
+        u32 kept = 0;
+        for(u32 idx=0; idx < columns->count; ++idx){
+            if(columns->nodes[idx]){
+                columns->nodes[kept] = columns->nodes[idx];
+                columns->cents[kept] = columns->cents[idx];
+                columns->date_keys[kept] = columns->date_keys[idx];
+                columns->row_ids[kept] = columns->row_ids[idx];
+                ++kept;
+            }
+        }
+        columns->count = kept;
+        if(!kept){
+            columns_release(columns);
+        }
+        import_month_chain(month);
+    }
+}
+
+// note: Moves every staged row's transaction into the columns of the month it's dated in, rows without a date
+// go to the month that was selected when the import started, then sorts each month's columns by date and chains
+// its transactions in that order. Rows the same account imported before are skipped, rows that might have been
+// are kept and listed in job->ambiguous for the user, see fingerprint_match(). Runs on the import thread:
+// pm->fingerprints is only read, the new set is a copy that's swapped in when publishing, and skipped
+// transactions go back to pm->transactions under pm->transaction_lock since the ui allocates from it too.
+// Returns false, with nothing left in the months, when there's no room for the batch.
+static bool
+stage_import_months(ImportJob* job){
+    FingerprintSet* fingerprints = &job->fingerprints;
+    bool staged = fingerprint_set_copy(fingerprints, &pm->fingerprints);
+
+    ImportBatch* batch = &job->batch;
+    for(u32 file_idx=0; file_idx < batch->file_count && staged; ++file_idx){
+        ImportFile* file = batch->files + file_idx;
+        for(StagedBlock* block = file->first; block && staged; block = block->next){
+            AcquireSRWLockExclusive(&pm->transaction_lock);
+            for(u64 row_idx=0; row_idx < block->count; ++row_idx){
+                StagedRow* row = block->rows + row_idx;
+                ImportMatch match = fingerprint_match(fingerprints, row->fingerprint, file->account);
+                if(match == ImportMatch_Duplicate){
+                    transaction_free(&pm->transactions, row->trans);
+                    row->trans = 0;
+                    ++job->duplicate_count;
+                    continue;
+                }
+
+                u32 m_idx = job->month_idx;
+                if(row->date_key){
+                    m_idx = date_key_month(row->date_key) - 1;
+                }
+                TransactionColumns* columns = &job->months[m_idx].columns;
+                if(!columns_reserve(columns, (u64)columns->count + 1) ||
+                   !fingerprint_set_insert_row(fingerprints, row->fingerprint, file->account) ||
+                   (match == ImportMatch_Ambiguous && !import_ambiguous_add(job, row->trans, m_idx))){
+                    staged = false;
+                    break;
+                }
+
+                Transaction* trans = row->trans;
+                row->trans = 0;
+                trans->fingerprint = row->fingerprint;
+                u32 idx = columns->count++;
+                columns->nodes[idx] = trans;
+                columns->cents[idx] = row->cents;
+                columns->date_keys[idx] = row->date_key;
+                columns->row_ids[idx] = ROW_HANDLE_NONE;
+            }
+            ReleaseSRWLockExclusive(&pm->transaction_lock);
+        }
+    }
+    if(!staged){
+        import_months_release(job);
+        return(false);
+    }
+
+    u32 max_count = 0;
+    for(u32 m_idx=0; m_idx < Month_Count; ++m_idx){
+        max_count = job->months[m_idx].columns.count > max_count ? job->months[m_idx].columns.count : max_count;
+    }
+
+    // note: the scratch arena belongs to the main thread, sort buffers are our own
+    u32* sort_memory = 0;
+    if(max_count > 1){
+        sort_memory = (u32*)VirtualAlloc(0, max_count * 4 * sizeof(u32), MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+        if(!sort_memory){
+            import_months_release(job);
+            return(false);
+        }
+    }
+    u32* keys = sort_memory;
+    u32* order = keys + max_count;
+    u32* temp_keys = order + max_count;
+    u32* temp = temp_keys + max_count;
+    for(u32 m_idx=0; m_idx < Month_Count; ++m_idx){
+        ImportMonth* month = job->months + m_idx;
+        TransactionColumns* columns = &month->columns;
+        if(columns->count > 1){
+            for(u32 idx=0; idx < columns->count; ++idx){
+                keys[idx] = columns->date_keys[idx] ? columns->date_keys[idx] : 0xFFFFFFFF;
+            }
+            radix_sort_dates(keys, order, temp_keys, temp, columns->count);
+
+            TransactionColumns sorted = {0};
+            if(!columns_reserve(&sorted, columns->count)){
+                VirtualFree(sort_memory, 0, MEM_RELEASE);
+                import_months_release(job);
+                return(false);
+            }
+            for(u32 idx=0; idx < columns->count; ++idx){
+                sorted.nodes[idx] = columns->nodes[order[idx]];
+                sorted.cents[idx] = columns->cents[order[idx]];
+                sorted.date_keys[idx] = columns->date_keys[order[idx]];
+                sorted.row_ids[idx] = columns->row_ids[order[idx]];
+            }
+            sorted.count = columns->count;
+            columns_release(columns);
+            *columns = sorted;
+        }
+        import_month_chain(month);
+    }
+    if(sort_memory){
+        VirtualFree(sort_memory, 0, MEM_RELEASE);
+    }
+    return(true);
+}
+
+// note: Parses the batch on the workers and stages the result, the main thread publishes it when finished is
+// set. A cancel stops the parsers between windows, once staging starts the import is finished regardless.
+static DWORD WINAPI
+import_job_proc(LPVOID param){
+    ImportJob* job = (ImportJob*)param;
+    ImportBatch* batch = &job->batch;
+
+    // note: The workers are split between files and the chunks of each file's windows, so a batch never runs
+    // more threads than there are workers. A batch with a file per worker parses every file in one chunk.
+    u32 worker_count = csv_worker_count();
+    if(worker_count > batch->file_count){
+        worker_count = batch->file_count;
+    }
+    for(u32 file_idx=0; file_idx < batch->file_count; ++file_idx){
+        batch->files[file_idx].worker_count = csv_worker_count() / worker_count;
+    }
+    HANDLE threads[CSV_MAX_CHUNKS];
+    for(u32 i=0; i < worker_count; ++i){
+        threads[i] = CreateThread(0, 0, import_worker_proc, batch, 0, 0);
+    }
+
+    bool* reported = push_array(job->arena, bool, batch->file_count);
+    memset(reported, 0, batch->file_count * sizeof(bool));
+    bool running = true;
+    while(running){
+        running = (WaitForMultipleObjects(worker_count, threads, TRUE, 250) == WAIT_TIMEOUT);
+        for(u32 file_idx=0; file_idx < batch->file_count; ++file_idx){
+            ImportFile* file = batch->files + file_idx;
+            if(file->done && !reported[file_idx]){
+                reported[file_idx] = true;
+                if(job->cancel){
+                    continue;
+                }
+                if(file->failed){
+                    print("Import: failed <%s>\n", file->path.str);
+                }
+                else{
+                    print("Import: %llu rows %.2f MB %.1f MB/s <%s>\n", file->row_count, (f64)file->size / MB(1),
+                          file->seconds > 0 ? (f64)file->size / MB(1) / file->seconds : 0.0, file->path.str);
+                }
+            }
+        }
+    }
+    for(u32 i=0; i < worker_count; ++i){
+        CloseHandle(threads[i]);
+    }
+
+    for(u32 file_idx=0; file_idx < batch->file_count; ++file_idx){
+        job->failed |= batch->files[file_idx].failed;
+        job->full |= batch->files[file_idx].full;
+        job->row_count += batch->files[file_idx].row_count;
+        job->duplicate_count += batch->files[file_idx].duplicate_count;
+    }
+    if(!job->failed && !job->cancel){
+        job->staged = stage_import_months(job);
+        job->full = !job->staged;
+    }
+    release_import(batch->files, batch->file_count);
+
+    job->seconds = clock.get_seconds_elapsed(clock.get_os_timer(), job->start);
+    MemoryBarrier();
+    job->finished = true;
+    return(0);
+}
+
+static ImportFile*
+import_add_file(String8 path, u64 size){
+    ImportBatch* batch = &import_job.batch;
+    ImportFile* file = batch->files + batch->file_count++;
+    memset(file, 0, sizeof(ImportFile));
+    file->path = str8_formatted(import_job.arena, "%.*s", (s32)path.size, path.str);
+    file->size = size;
+    file->cancel = &import_job.cancel;
+    return(file);
+}
+
+// note: the files are added with import_add_file() between import_begin() and import_start()
+static bool
+import_begin(u32 file_count){
+    if(import_job.active){
+        print("Import: an import is already running\n");
+        return(false);
+    }
+    Arena* arena = import_job.arena;
+    if(!arena){
+        arena = push_arena(&pm->arena, MB(4));
+    }
+    arena_free(arena);
+
+    import_job = {0};
+    import_job.arena = arena;
+    import_job.month_idx = (u32)(pm->month - pm->months);
+    import_job.batch.files = push_array(arena, ImportFile, file_count);
+    return(true);
+}
+
+static void
+import_start(void){
+    import_job.active = true;
+    import_job.start = clock.get_os_timer();
+    import_job.thread = CreateThread(0, 0, import_job_proc, &import_job, 0, 0);
+}
+
+// note: fraction of the batch parsed and the bytes per second so far, a file counts once it's been opened
+static f32
+import_progress(f64* bytes_per_second){
+    u64 bytes_done = 0;
+    u64 total_size = 0;
+    ImportBatch* batch = &import_job.batch;
+    for(u32 file_idx=0; file_idx < batch->file_count; ++file_idx){
+        ImportFile* file = batch->files + file_idx;
+        bytes_done += file->done ? file->size : file->bytes_done;
+        total_size += file->size;
+    }
+    f64 seconds = clock.get_seconds_elapsed(clock.get_os_timer(), import_job.start);
+    *bytes_per_second = seconds > 0 ? (f64)bytes_done / seconds : 0.0;
+    f32 result = total_size ? (f32)((f64)bytes_done / (f64)total_size) : 0.0f;
+    return(result);
+}
+
+// note: Called at the top of a frame. The import thread did everything per row, publishing splices each
+// month's sorted chain onto the end of the month and hands its columns over. A month without transactions
+// takes them as they are, otherwise they're copied onto the end of its own in one go and only the new
+// transactions' column indices move. The month's own transactions keep their order, the user may have dragged
+// them. Imported transactions don't have a row yet, so all they change in the totals is the month's unmuted count.
+// An import with ambiguous rows waits for the user to import or skip them, see import_ambiguous_decide().
+static void
+import_publish(void){
+    if(!import_job.active || !import_job.finished){
+        return;
+    }
+    if(import_job.staged && import_job.ambiguous_count && !import_job.ambiguous_decided){
+        return;
+    }
+    WaitForSingleObject(import_job.thread, INFINITE);
+    CloseHandle(import_job.thread);
+    import_job.active = false;
+
+    ImportBatch* batch = &import_job.batch;
+    if(!import_job.staged){
+        if(import_job.cancel){
+            print("Import: cancelled\n");
+        }
+        else if(import_job.full){
+            print("Import: batch not committed, out of memory for its %llu rows\n", import_job.row_count);
+        }
+        else{
+            print("Import: batch not committed, a file failed to parse\n");
+        }
+        return;
+    }
+    if(import_job.ambiguous_skipped){
+        import_months_skip(&import_job);
+    }
+
+    // note: every month makes room in its columns before anything is spliced, a batch that doesn't fit is dropped whole
+    for(u32 m_idx=0; m_idx < Month_Count; ++m_idx){
+        TransactionColumns* columns = &pm->months[m_idx].columns;
+        u32 count = import_job.months[m_idx].columns.count;
+        if(count && columns->count && !columns_reserve(columns, (u64)columns->count + count)){
+            print("Import: batch not committed, out of memory for its %llu rows\n", import_job.row_count);
+            import_months_release(&import_job);
+            return;
+        }
+    }
+
+    for(u32 m_idx=0; m_idx < Month_Count; ++m_idx){
+        ImportMonth* staged = import_job.months + m_idx;
+        u32 count = staged->columns.count;
+        if(!count){
+            continue;
+        }
+        MonthInfo* month = pm->months + m_idx;
+        TransactionColumns* columns = &month->columns;
+        if(!columns->count){
+            columns_release(columns);
+            *columns = staged->columns;
+        }
+        else{
+            u32 at = columns->count;
+            memcpy(columns->nodes + at, staged->columns.nodes, count * sizeof(Transaction*));
+            memcpy(columns->cents + at, staged->columns.cents, count * sizeof(s64));
+            memcpy(columns->date_keys + at, staged->columns.date_keys, count * sizeof(u32));
+            memcpy(columns->row_ids + at, staged->columns.row_ids, count * sizeof(u32));
+            columns->count += count;
+            for(u32 idx=at; idx < columns->count; ++idx){
+                columns->nodes[idx]->column = idx + 1;
+            }
+            columns_release(&staged->columns);
+        }
+        staged->columns = {0};
+
+        Transaction* tail = month->transactions->prev;
+        tail->next = staged->first;
+        staged->first->prev = tail;
+        staged->last->next = month->transactions;
+        month->transactions->prev = staged->last;
+        month->transactions_count += count;
+        totals_month_unmuted(month, (s32)count);
+        pm->totals_dirty = true;
+    }
+
+    fingerprint_set_release(&pm->fingerprints);
+    pm->fingerprints = import_job.fingerprints;
+    import_job.fingerprints = {0};
+    // note: Headers that resolved every column are remembered for next time. Partly resolved ones aren't,
+    // adding the missing alias to config.conf has to keep working for them.
+    bool learned = false;
+    for(u32 file_idx=0; file_idx < batch->file_count; ++file_idx){
+        ImportFile* file = batch->files + file_idx;
+        if(file->watermark.source){
+            watermark_set(&file->watermark);
+        }
+        if(file->prepared && file->account){
+            ImportAccount account = {file->source};
+            memcpy(account.name, file->account_name, sizeof(account.name));
+            import_account_set(&account);
+        }
+        if(file->prepared && !file->profiled && !file->failed &&
+           file->layout.date_idx >= 0 && file->layout.amount_idx >= 0 && file->layout.desc_idx >= 0){
+            ImportProfile profile = {file->header, file->layout, file->dialect};
+            import_profile_set(&profile);
+            learned = true;
+        }
+    }
+    if(learned){
+        save_profiles();
+    }
+
+    u64 total_size = 0;
+    for(u32 file_idx=0; file_idx < batch->file_count; ++file_idx){
+        total_size += batch->files[file_idx].size;
+    }
+    f64 seconds = import_job.seconds;
+    print("Import: %u files %llu rows (%llu already imported) %.2f MB in %.3fs (%.1f MB/s)\n", batch->file_count, import_job.row_count,
+          import_job.duplicate_count, (f64)total_size / MB(1), seconds, seconds > 0 ? (f64)total_size / MB(1) / seconds : 0.0);
+    if(import_job.ambiguous_count){
+        print("Import: %llu rows that might have been imported before were %s\n", import_job.ambiguous_count,
+              import_job.ambiguous_skipped ? "skipped" : "imported");
+    }
+    import_ambiguous_release(&import_job);
+}
+
+// note: answer for the ambiguous rows of a finished import, it's published at the top of the next frame
+static void
+import_ambiguous_decide(bool skip){
+    import_job.ambiguous_skipped = skip;
+    import_job.ambiguous_decided = true;
+}
+
+// note: before saving on quit, a finished import is kept and a running one is cancelled. Ambiguous rows
+// nobody decided on are imported, deleting a duplicate is easier than finding a missing transaction.
+static void
+import_shutdown(void){
+    if(!import_job.active){
+        return;
+    }
+    import_job.cancel = true;
+    WaitForSingleObject(import_job.thread, INFINITE);
+    if(!import_job.ambiguous_decided){
+        import_ambiguous_decide(false);
+    }
+    import_publish();
+}
+
+// note: one csv, ofx, qfx or qif statement, imported in the background
+static void
+load_statement(String8 full_path){
+    begin_timed_scope("load_statement");
+    if(import_begin(1)){
+        import_add_file(full_path, 0);
+        import_start();
+    }
+}
+
+static void
+preview_discard(void){
+    release_import(&import_preview.file, 1);
+    import_preview = {0};
+}
+
+// note: Parses the header and the rows in the first IMPORT_PREVIEW_SIZE bytes on the spot, nothing is
+// imported until preview_confirm()
+static void
+preview_statement(String8 full_path){
+    begin_timed_scope("preview_statement");
+    preview_discard();
+
+    ImportPreview* preview = &import_preview;
+    u64 start = clock.get_os_timer();
+    u32 path_size = full_path.size < sizeof(preview->path) - 1 ? (u32)full_path.size : sizeof(preview->path) - 1;
+    memcpy(preview->path, full_path.str, path_size);
+    preview->path[path_size] = 0;
+
+    ImportFile* file = &preview->file;
+    file->path = str8(preview->path, path_size);
+    MappedFile mapped = os_open_mapping(file->path);
+    if(!mapped.mapping){
+        //todo: log error
+        print("Error: failed to open file <%s>\n", file->path.str);
+        os_close_mapping(&mapped);
+        return;
+    }
+    file->size = mapped.file.size;
+
+    u64 data_start = 0;
+    CSVReader reader = csv_reader(&mapped, &data_start);
+    csv_prepare_import(file, &mapped, &reader, data_start, preview);
+
+    CSVWindows windows = csv_windows(&reader, file->offset, IMPORT_PREVIEW_SIZE, file->layout, file->dialect, 1);
+    if(csv_next_window(&windows)){
+        csv_stage_window(file, &windows);
+        csv_window_done(&windows);
+        file->offset = windows.offset;
+        file->bytes_done = file->offset;
+    }
+
+    csv_reader_release(&reader);
+    os_close_mapping(&mapped);
+
+    preview->seconds = clock.get_seconds_elapsed(clock.get_os_timer(), start);
+    preview->open = true;
+}
+
+// note: The preview's rows are kept and the import carries on after them. False while another import is
+// running, the preview stays open with preview->error saying so and can be confirmed once it's done.
+static bool
+preview_confirm(void){
+    ImportPreview* preview = &import_preview;
+    if(!preview->open){
+        return(false);
+    }
+    if(!import_begin(1)){
+        preview->error = "another import is still running, import again once it's done";
+        return(false);
+    }
+    ImportFile* file = import_add_file(preview->file.path, preview->file.size);
+    String8 path = file->path;
+    *file = preview->file;
+    file->path = path;
+    file->account = import_account_id(str8(file->account_name, char_length(file->account_name)));
+    file->cancel = &import_job.cancel;
+    import_start();
+
+    // note: the staged blocks belong to the import now
+    import_preview = {0};
+    return(true);
+}
+
+// note: Imports every .csv, .ofx, .qfx and .qif in a folder in the background. Files are parsed concurrently,
+// one per worker at a time, and committed together only if every file parsed, so a failed batch can be fixed
+// and rerun as a whole.
+static void
+load_statement_folder(String8 folder){
+    begin_timed_scope("load_statement_folder");
+    ScratchArena scratch = begin_scratch();
+
+    String8 pattern = str8_formatted(scratch.arena, "%.*s\\*", (s32)folder.size, folder.str);
+    WIN32_FIND_DATAA find;
+    u32 file_count = 0;
+    HANDLE find_handle = FindFirstFileA((char*)pattern.str, &find);
+    if(find_handle != INVALID_HANDLE_VALUE){
+        do{
+            String8 name = str8(find.cFileName, char_length(find.cFileName));
+            if(!(find.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && is_statement_path(name)){
+                ++file_count;
+            }
+        } while(FindNextFileA(find_handle, &find));
+        FindClose(find_handle);
+    }
+    if(!file_count){
+        print("Error: no csv, ofx, qfx or qif files in <%s>\n", folder.str);
+        end_scratch(scratch);
+        return;
+    }
+    if(file_count > IMPORT_MAX_FILES){
+        print("Import: %u files in <%s>, only the first %u are imported\n", file_count, folder.str, IMPORT_MAX_FILES);
+        file_count = IMPORT_MAX_FILES;
+    }
+    if(!import_begin(file_count)){
+        end_scratch(scratch);
+        return;
+    }
+
+    find_handle = FindFirstFileA((char*)pattern.str, &find);
+    if(find_handle != INVALID_HANDLE_VALUE){
+        do{
+            String8 name = str8(find.cFileName, char_length(find.cFileName));
+            if(!(find.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && is_statement_path(name) && import_job.batch.file_count < file_count){
+                String8 path = str8_formatted(scratch.arena, "%.*s\\%s", (s32)folder.size, folder.str, find.cFileName);
+                import_add_file(path, ((u64)find.nFileSizeHigh << 32) | find.nFileSizeLow);
+            }
+        } while(FindNextFileA(find_handle, &find));
+        FindClose(find_handle);
+    }
+    import_start();
+    end_scratch(scratch);
+}
+
+static void
+load_config(void){
+    ScratchArena scratch = begin_scratch();
+    String8 full_path = str8_path_append(scratch.arena, build_path, str8_literal("config.conf"));
+
+    File file = os_file_open(full_path, GENERIC_READ, OPEN_EXISTING);
+    if(!file.size){
+        //todo: log error
+        print("Error: failed to open file <%s>\n", full_path.str);
+        os_file_close(file);
+        end_scratch(scratch);
+        return;
+    }
+
+    String8 data = os_file_read(scratch.arena, file);
+    CSVScanner scanner = csv_scanner(data, ',', '"');
+
+    // note: every alias takes at least a byte and a separator, so this bounds the alias count
+    CSVAlias* aliases = push_array(scratch.arena, CSVAlias, data.size / 2 + 1);
+    u32 aliases_count = 0;
+
+    state = ParsingState_None;
+    CSVField field;
+    while(csv_next_field(&scanner, &field)){
+        String8 word = field.text;
+        str8_eat_spaces(&word);
+        if(!word.size){
+            continue;
+        }
+
+        if(str8_starts_with(word, str8_literal("#"))){
+            if(str8_compare(word, str8_literal("#date"))){
+                state = ParsingState_Date;
+            }
+            else if(str8_compare(word, str8_literal("#amount"))){
+                state = ParsingState_Amount;
+            }
+            else if(str8_compare(word, str8_literal("#description"))){
+                state = ParsingState_Description;
+            }
+        }
+        else if(state == ParsingState_Date){
+            aliases[aliases_count++] = {word, CSVRole_Date};
+        }
+        else if(state == ParsingState_Amount){
+            aliases[aliases_count++] = {word, CSVRole_Amount};
+        }
+        else if(state == ParsingState_Description){
+            aliases[aliases_count++] = {word, CSVRole_Description};
+        }
+    }
+    state = ParsingState_None;
+
+    // note: names are copied out of the file data, so the table outlives scratch
+    pm->header_aliases = csv_alias_table(&pm->arena, aliases, aliases_count);
+
+    os_file_close(file);
+    end_scratch(scratch);
+}
+
+// note: lowercase hex number at the front of line, line is advanced past it and the spaces after it
+static u64
+eat_hex(String8* line){
+    u64 result = 0;
+    u64 i = 0;
+    for(; i < line->size; ++i){
+        u8 c = line->str[i];
+        u8 digit = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : 0xFF;
+        if(digit == 0xFF){
+            break;
+        }
+        result = (result << 4) | digit;
+    }
+    for(; i < line->size && line->str[i] == ' '; ++i);
+    str8_advance(line, i);
+    return(result);
+}
+
+static void
+load_profiles(void){
+    ScratchArena scratch = begin_scratch();
+    String8 full_path = str8_path_append(scratch.arena, build_path, str8_literal("profiles.conf"));
+
+    // note: no profiles yet is fine, they're learned on the first import of each bank
+    File file = os_file_open(full_path, GENERIC_READ, OPEN_EXISTING);
+    if(!file.size){
+        os_file_close(file);
+        end_scratch(scratch);
+        return;
+    }
+
+    String8 data = os_file_read(scratch.arena, file);
+    while(data.size){
+        u64 line_size = 0;
+        for(; line_size < data.size && data.str[line_size] != '\n'; ++line_size);
+        String8 line = str8(data.str, line_size);
+        str8_advance(&data, line_size < data.size ? line_size + 1 : line_size);
+        if(line.size && line.str[line.size - 1] == '\r'){
+            --line.size;
+        }
+        if(!line.size || line.str[0] == '#'){
+            continue;
+        }
+
+        ImportProfile profile = {0};
+        profile.header = eat_hex(&line);
+        profile.layout.date_idx = (s32)eat_hex(&line);
+        profile.layout.amount_idx = (s32)eat_hex(&line);
+        profile.layout.desc_idx = (s32)eat_hex(&line);
+        profile.layout.column_count = (s32)eat_hex(&line);
+        profile.dialect.delimiter = (u8)eat_hex(&line);
+        profile.dialect.quote = (u8)eat_hex(&line);
+        profile.dialect.decimal = (u8)eat_hex(&line);
+        profile.dialect.day_first = eat_hex(&line) != 0;
+
+        s32 columns = profile.layout.column_count;
+        if(profile.header && profile.dialect.delimiter && columns > 0 &&
+           profile.layout.date_idx >= 0 && profile.layout.date_idx < columns &&
+           profile.layout.amount_idx >= 0 && profile.layout.amount_idx < columns &&
+           profile.layout.desc_idx >= 0 && profile.layout.desc_idx < columns){
+            import_profile_set(&profile);
+        }
+    }
+
+    os_file_close(file);
+    end_scratch(scratch);
+}
+
+// note: Budgets saved before fingerprints were keyed on accounts have keys nothing matches anymore. Their
+// transactions are fingerprinted again as rows of no known account, so reimporting one of those statements
+// asks about the overlap instead of importing it twice. Copies are counted like fingerprint_staged_rows() does.
+// Ofx rows that were fingerprinted on their FITID aren't recognised, the budget doesn't keep it.
+static void
+fingerprints_from_transactions(void){
+    FingerprintSet seen = {0};
+    for(u32 m_idx=0; m_idx < Month_Count; ++m_idx){
+        MonthInfo* month = pm->months + m_idx;
+        Transaction* trans = month->transactions;
+        for(u32 t_idx=0; t_idx < month->transactions_count; ++t_idx){
+            trans = trans->next;
+            u64 base = fingerprint_transaction(trans->description, transaction_date_key(month, trans), transaction_cents(month, trans));
+            u64 fingerprint = base;
+            for(u64 copy=1; fingerprint_set_contains(&seen, fingerprint); ++copy){
+                fingerprint = fingerprint_copy(base, copy);
+            }
+            if(!fingerprint_set_insert(&seen, fingerprint) || !fingerprint_set_insert_row(&pm->fingerprints, fingerprint, 0)){
+                print("Load: no memory to fingerprint the transactions again, they can be imported twice\n");
+                fingerprint_set_release(&seen);
+                return;
+            }
+        }
+    }
+    fingerprint_set_release(&seen);
+}
+
+static void
+deserialize_data(void){
+    ScratchArena scratch = begin_scratch();
+    String8 full_path = str8_path_append(scratch.arena, saves_path, str8_literal("budget.b"));
+
+    File file = os_file_open(full_path, GENERIC_READ, OPEN_EXISTING);
+    if(!file.size){
+        //todo: log error
+        print("Error: file size 0, no data to load. <%s>\n", (char*)full_path.str);
+        os_file_close(file);
+        end_scratch(scratch);
+        return;
+    }
+
+    String8 data = os_file_read(scratch.arena, file);
+    // note: only splitting lines here, descriptions can contain quotes so quote tracking is off
+    CSVScanner lines = csv_scanner(data, '\n', 0);
+
+    s32 month_idx = 0;
+    bool legacy_fingerprints = false;
+    state = ParsingState_None;
+    CSVField field;
+    while(csv_next_field(&lines, &field)){
+        String8 line = field.text;
 
         if(str8_starts_with(line, str8_literal("#"))){
-            if(str8_compare(line, str8_literal("#budget\n"))){
+            if(str8_compare(line, str8_literal("#budget"))){
                 state = ParsingState_Budget;
             }
-            else if(str8_compare(line, str8_literal("#category\n"))){
+            else if(str8_compare(line, str8_literal("#category"))){
                 state = ParsingState_Category;
             }
             else if(str8_contains(line, str8_literal("#month"))){
@@ -658,9 +3094,22 @@ deserialize_data(void){
                 pm->month = pm->months + month_idx;
                 ++month_idx;
             }
-            else if(str8_compare(line, str8_literal("#config\n"))){
+            else if(str8_compare(line, str8_literal("#config"))){
                 state = ParsingState_Config;
             }
+            else if(str8_compare(line, str8_literal("#imported"))){
+                state = ParsingState_Fingerprints;
+            }
+            else if(str8_compare(line, str8_literal("#fingerprints")) || str8_compare(line, str8_literal("#header_fingerprints"))){
+                state = ParsingState_LegacyFingerprints;
+                legacy_fingerprints = true;
+            }
+            else if(str8_compare(line, str8_literal("#watermarks"))){
+                state = ParsingState_Watermarks;
+            }
+            else if(str8_compare(line, str8_literal("#accounts"))){
+                state = ParsingState_Accounts;
+            }
         }
         else if(state == ParsingState_Budget){
             String8 word = str8_eat_word(&line);
@@ -698,10 +3147,6 @@ deserialize_data(void){
                     str8_node = str8_split(scratch.arena, word, '=');
                     category->draw_rows = atoi((char*)str8_node.prev->str.str);
                 }
-                else if(str8_contains(word, str8_literal("muted"))){
-                    str8_node = str8_split(scratch.arena, word, '=');
-                    category->muted = atoi((char*)str8_node.prev->str.str);
-                }
             }
             state = ParsingState_Row;
         }
@@ -713,6 +3158,8 @@ deserialize_data(void){
             dll_push_back(category->rows, row);
             ++pm->total_rows_count;
 
+            u32 wanted_id = ROW_HANDLE_NONE;
+            bool muted = false;
             while(line.size){
                 String8 word = str8_eat_word(&line);
 
@@ -736,9 +3183,15 @@ deserialize_data(void){
                 }
                 else if(str8_contains(word, str8_literal("muted"))){
                     str8_node = str8_split(scratch.arena, word, '=');
-                    row->muted = atoi((char*)str8_node.prev->str.str);
+                    muted = atoi((char*)str8_node.prev->str.str);
+                }
+                else if(str8_starts_with(word, str8_literal("id="))){
+                    str8_node = str8_split(scratch.arena, word, '=');
+                    wanted_id = atoi((char*)str8_node.prev->str.str);
                 }
             }
+            row_handle_acquire(row, wanted_id);
+            row_set_muted(row, muted);
         }
         else if(state == ParsingState_Month){
             while(line.size){
@@ -754,11 +3207,21 @@ deserialize_data(void){
         }
         else if(state == ParsingState_Transaction){
 
-            Transaction* trans;
+            Transaction* trans = 0;
+            s64 cents = 0;
+            u32 date_key = 0;
+            u32 row_id = ROW_HANDLE_NONE;
+            bool muted = false;
             if(line.size){
-                trans = (Transaction*)pool_next(pm->transaction_pool);
-                dll_push_back(pm->month->transactions, trans);
-                ++pm->month->transactions_count;
+                trans = transaction_alloc(&pm->transactions);
+                if(trans){
+                    dll_push_back(pm->month->transactions, trans);
+                    ++pm->month->transactions_count;
+                }
+                else{
+                    print("Load: no room for more transactions, skipped: %.*s\n", (s32)line.size, line.str);
+                    line.size = 0;
+                }
             }
 
             while(line.size){
@@ -772,6 +3235,7 @@ deserialize_data(void){
                     }
                     else{
                         copy_word_to_char(trans->date, str8_node.prev->str);
+                        date_key = csv_parse_date(str8_node.prev->str, false);
                     }
                 }
                 else if(str8_contains(word, str8_literal("amount"))){
@@ -781,6 +3245,7 @@ deserialize_data(void){
                     }
                     else{
                         copy_word_to_char(trans->amount, str8_node.prev->str);
+                        cents = csv_parse_amount(str8_node.prev->str, '.');
                     }
                 }
                 else if(str8_contains(word, str8_literal("description"))){
@@ -796,22 +3261,41 @@ deserialize_data(void){
                         copy_word_to_char(trans->description, str8_node.prev->str);
                     }
                 }
+                else if(str8_starts_with(word, str8_literal("row="))){
+                    str8_node = str8_split(scratch.arena, word, '=');
+                    row_id = atoi((char*)str8_node.prev->str.str);
+                    if(row_id >= ROW_HANDLE_MAX){
+                        row_id = ROW_HANDLE_NONE;
+                    }
+                }
                 else if(str8_contains(word, str8_literal("selection"))){
                     if(!str8_contains_byte(word, '\x1B')){
                         u32 count = str8_extend_to_char(&word, '\x1B');
                         str8_advance(&line, count);
                     }
                     str8_node = str8_split(scratch.arena, word, '=');
-                    if(str8_compare(str8_node.prev->str, str8_node.next->str)){
-                        copy_word_to_char(trans->selection, str8_literal("\0"));
+                    String8 selection = str8_node.prev->str;
+                    while(selection.size && (selection.str[selection.size - 1] == '\x1B' || selection.str[selection.size - 1] == '\n')){
+                        --selection.size;
                     }
-                    else{
-                        copy_word_to_char(trans->selection, str8_node.prev->str);
+                    if(!str8_compare(str8_node.prev->str, str8_node.next->str)){
+                        row_id = row_handle_from_selection(selection);
                     }
                 }
                 else if(str8_contains(word, str8_literal("muted"))){
                     str8_node = str8_split(scratch.arena, word, '=');
-                    trans->muted = atoi((char*)str8_node.prev->str.str);
+                    muted = atoi((char*)str8_node.prev->str.str);
+                }
+            }
+            if(trans){
+                if(columns_store(&pm->month->columns, trans, cents, date_key, row_id)){
+                    columns_set_muted(&pm->month->columns, trans->column - 1, muted);
+                }
+                else{
+                    print("Load: no room for more transactions, skipped: %s %s %s\n", trans->date, trans->amount, trans->description);
+                    dll_remove(trans);
+                    --pm->month->transactions_count;
+                    transaction_free(&pm->transactions, trans);
                 }
             }
         }
@@ -834,6 +3318,35 @@ deserialize_data(void){
                 }
             }
         }
+        else if(state == ParsingState_Fingerprints){
+            u64 fingerprint = eat_hex(&line);
+            if(fingerprint){
+                fingerprint_set_insert(&pm->fingerprints, fingerprint);
+            }
+        }
+        else if(state == ParsingState_Watermarks){
+            Watermark watermark = {0};
+            watermark.source = eat_hex(&line);
+            watermark.offset = eat_hex(&line);
+            watermark.anchor = eat_hex(&line);
+            watermark.anchor_size = (u32)eat_hex(&line);
+            if(watermark.source && watermark.offset && watermark.anchor_size <= WATERMARK_ANCHOR_SIZE){
+                watermark_set(&watermark);
+            }
+        }
+        else if(state == ParsingState_Accounts){
+            // note: the name is the rest of the line
+            ImportAccount account = {0};
+            account.source = eat_hex(&line);
+            u64 size = line.size < sizeof(account.name) - 1 ? line.size : sizeof(account.name) - 1;
+            memcpy(account.name, line.str, size);
+            if(account.source && import_account_id(str8(account.name, size))){
+                import_account_set(&account);
+            }
+        }
+    }
+    if(legacy_fingerprints){
+        fingerprints_from_transactions();
     }
 
     state = ParsingState_None;
@@ -841,61 +3354,125 @@ deserialize_data(void){
     end_scratch(scratch);
 }
 
+// note: Fingerprints grow with every import, they're formatted into their own buffer, released by the caller.
+// Empty if the buffer can't be allocated.
+static String8
+serialize_fingerprints(const char* section, FingerprintSet* set){
+    String8 result = {0};
+    u64 size = KB(1) + set->count * 17;
+    char* buffer = (char*)VirtualAlloc(0, size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+    if(!buffer){
+        return(result);
+    }
+    u64 at = snprintf(buffer, size, "%s\n", section);
+    for(u64 i=0; i < set->capacity; ++i){
+        if(set->slots[i]){
+            at += snprintf(buffer + at, size - at, "%016llx\n", set->slots[i]);
+        }
+    }
+    result = str8(buffer, at);
+    return(result);
+}
+
+// note: Lines are at most their text fields plus a little for names and numbers, so the buffer is sized from
+// the counts and every snprintf fits. Nothing is written if it can't be allocated, the last save stays.
+#define SERIALIZE_LINE_EXTRA 64
 static void
 serialize_data(void){
-    Arena* arena = pm->data_arena;
+    u64 size = KB(4) + pm->watermarks_count * SERIALIZE_LINE_EXTRA + pm->accounts_count * (sizeof(ImportAccount::name) + SERIALIZE_LINE_EXTRA);
     Category* c = pm->categories;
+    for(s32 c_idx = 0; c_idx < pm->categories_count; ++c_idx){
+        c = c->next;
+        size += sizeof(c->name) + SERIALIZE_LINE_EXTRA;
+        size += c->row_count * (sizeof(Row::name) + sizeof(Row::planned) + SERIALIZE_LINE_EXTRA);
+    }
+    for(s32 m_idx=0; m_idx < Month_Count; ++m_idx){
+        size += pm->months[m_idx].transactions_count *
+                (sizeof(Transaction::date) + sizeof(Transaction::amount) + sizeof(Transaction::description) + SERIALIZE_LINE_EXTRA);
+    }
+    char* buffer = (char*)VirtualAlloc(0, size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+    if(!buffer){
+        print("Save: couldn't get %llu bytes to save, budget.b not written\n", size);
+        return;
+    }
+    u64 at = 0;
+    c = pm->categories;
 
-    arena->at += snprintf((char*)arena->base + arena->at, arena->size - arena->at, "#budget\n");
-    arena->at += snprintf((char*)arena->base + arena->at, arena->size - arena->at, "budget=%s\n", pm->budget.str);
-    //arena->at += snprintf((char*)arena->base + arena->at, arena->size - arena->at, "budget=%s\n", pm->budget);
+    at += snprintf(buffer + at, size - at, "#budget\n");
+    at += snprintf(buffer + at, size - at, "budget=%s\n", pm->budget.str);
+    //at += snprintf(buffer + at, size - at, "budget=%s\n", pm->budget);
 
     for(s32 c_idx = 0; c_idx < pm->categories_count; ++c_idx){
         c = c->next;
 
-        arena->at += snprintf((char*)arena->base + arena->at, arena->size - arena->at, "#category\n");
-        arena->at += snprintf((char*)arena->base + arena->at, arena->size - arena->at,
-                              "name=%s\x1B draw_rows=%i muted=%i\n", c->name, c->draw_rows, c->muted);
+        at += snprintf(buffer + at, size - at, "#category\n");
+        at += snprintf(buffer + at, size - at,
+                       "name=%s\x1B draw_rows=%i muted=%i\n", c->name, c->draw_rows, category_muted(c));
 
         Row* r = c->rows;
         for(s32 r_idx = 0; r_idx < c->row_count; ++r_idx){
             r = r->next;
-            arena->at += snprintf((char*)arena->base + arena->at, arena->size - arena->at,
-                                  "\tname=%s\x1B planned=%s muted=%i\n", r->name, r->planned, r->muted);
+            at += snprintf(buffer + at, size - at,
+                           "\tname=%s\x1B planned=%s muted=%i id=%u\n", r->name, r->planned, row_muted(r), r->id);
         }
     }
 
     for(s32 m_idx=0; m_idx < Month_Count; ++m_idx){
 
         pm->month = pm->months + m_idx;
-        arena->at += snprintf((char*)arena->base + arena->at, arena->size - arena->at, "#month_m%i\n", m_idx);
-        arena->at += snprintf((char*)arena->base + arena->at, arena->size - arena->at, "muted=%i\n", pm->month->muted);
+        at += snprintf(buffer + at, size - at, "#month_m%i\n", m_idx);
+        at += snprintf(buffer + at, size - at, "muted=%i\n", pm->month->muted);
 
         Transaction* t = pm->month->transactions;
         for(s32 t_idx = 0; t_idx < pm->month->transactions_count; ++t_idx){
             t = t->next;
-            arena->at += snprintf((char*)arena->base + arena->at, arena->size - arena->at,
-                                  "date=%s amount=%s description=%s\x1B selection=%s\x1B muted=%i\n",
-                                  t->date, t->amount, t->description, t->selection, t->muted);
+            at += snprintf(buffer + at, size - at,
+                           "date=%s amount=%s description=%s\x1B row=%u muted=%i\n",
+                           t->date, t->amount, t->description, transaction_row_id(pm->month, t), transaction_muted(pm->month, t));
         }
     }
-    arena->at += snprintf((char*)arena->base + arena->at, arena->size - arena->at, "#config\n");
-    arena->at += snprintf((char*)arena->base + arena->at, arena->size - arena->at,
-                          "month_tab_idx=%i quarter_tab_idx=%i biannual_tab_idx=%i\n",
-                          pm->month_tab_idx, pm->quarter_tab_idx, pm->biannual_tab_idx);
+    at += snprintf(buffer + at, size - at, "#config\n");
+    at += snprintf(buffer + at, size - at,
+                   "month_tab_idx=%i quarter_tab_idx=%i biannual_tab_idx=%i\n",
+                   pm->month_tab_idx, pm->quarter_tab_idx, pm->biannual_tab_idx);
+
+    at += snprintf(buffer + at, size - at, "#watermarks\n");
+    for(u32 w_idx=0; w_idx < pm->watermarks_count; ++w_idx){
+        Watermark* w = pm->watermarks + w_idx;
+        at += snprintf(buffer + at, size - at,
+                       "%016llx %llx %016llx %x\n", w->source, w->offset, w->anchor, w->anchor_size);
+    }
 
-    arena->at += snprintf((char*)arena->base + arena->at, arena->size - arena->at, "\0");
+    at += snprintf(buffer + at, size - at, "#accounts\n");
+    for(u32 a_idx=0; a_idx < pm->accounts_count; ++a_idx){
+        ImportAccount* a = pm->accounts + a_idx;
+        at += snprintf(buffer + at, size - at, "%016llx %s\n", a->source, a->name);
+    }
 
-    ScratchArena scratch = begin_scratch();
-    String8 full_path = str8_path_append(scratch.arena, saves_path, str8_literal("budget.b"));
+    at += snprintf(buffer + at, size - at, "\0");
 
-    File file = os_file_open(full_path, GENERIC_WRITE, CREATE_ALWAYS);
-    if(file.handle != INVALID_HANDLE_VALUE){
-        os_file_write(file, arena->base, arena->at);
+    String8 fingerprints = serialize_fingerprints("#imported", &pm->fingerprints);
+    if(fingerprints.str){
+        ScratchArena scratch = begin_scratch();
+        String8 full_path = str8_path_append(scratch.arena, saves_path, str8_literal("budget.b"));
+
+        File file = os_file_open(full_path, GENERIC_WRITE, CREATE_ALWAYS);
+        if(file.handle != INVALID_HANDLE_VALUE){
+            os_file_write(file, (u8*)buffer, at);
+            os_file_write(file, fingerprints.str, fingerprints.size);
+        }
+
+        os_file_close(file);
+        end_scratch(scratch);
+    }
+    else{
+        print("Save: couldn't get memory for the fingerprints, budget.b not written\n");
     }
 
-    os_file_close(file);
-    end_scratch(scratch);
+    if(fingerprints.str){
+        VirtualFree(fingerprints.str, 0, MEM_RELEASE);
+    }
+    VirtualFree(buffer, 0, MEM_RELEASE);
 }
 
 
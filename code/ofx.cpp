@@ -0,0 +1,215 @@
+#ifndef OFX_C
+#define OFX_C
+
+static OFXTokenizer
+ofx_tokenizer(String8 data, bool final){
+    OFXTokenizer result = {0};
+    result.data = data;
+    result.final = final;
+    return(result);
+}
+
+static String8
+ofx_trim(String8 string){
+    while(string.size && (string.str[0] == ' ' || string.str[0] == '\t' || string.str[0] == '\r' || string.str[0] == '\n')){
+        str8_advance(&string, 1);
+    }
+    while(string.size && (string.str[string.size - 1] == ' ' || string.str[string.size - 1] == '\t' ||
+                          string.str[string.size - 1] == '\r' || string.str[string.size - 1] == '\n')){
+        --string.size;
+    }
+    return(string);
+}
+
+static u8*
+ofx_find(OFXTokenizer* tokenizer, u64 from, u8 c){
+    if(from >= tokenizer->data.size){
+        return(0);
+    }
+    u8* result = (u8*)memchr(tokenizer->data.str + from, c, tokenizer->data.size - from);
+    return(result);
+}
+
+static bool
+ofx_next_token(OFXTokenizer* tokenizer, OFXToken* token){
+    String8 data = tokenizer->data;
+    for(;;){
+        u8* open = ofx_find(tokenizer, tokenizer->at, '<');
+        if(!open){
+            // note: text outside any tag (the SGML header, whitespace) is skipped
+            tokenizer->at = data.size;
+            return(false);
+        }
+        u64 start = open - data.str;
+        u8* close = ofx_find(tokenizer, start, '>');
+        if(!close){
+            tokenizer->at = tokenizer->final ? data.size : start;
+            return(false);
+        }
+        String8 tag = {open + 1, (u64)(close - open) - 1};
+        u64 after = (close - data.str) + 1;
+
+        // note: <?xml ?>, <?OFX ?> and <!-- --> carry nothing we need
+        if(tag.size && (tag.str[0] == '?' || tag.str[0] == '!')){
+            if(str8_starts_with(tag, str8_literal("!--"))){
+                u64 at = start + 4;
+                bool found = false;
+                while(!found){
+                    u8* dash = ofx_find(tokenizer, at, '>');
+                    if(!dash){
+                        break;
+                    }
+                    at = (dash - data.str) + 1;
+                    found = (dash - data.str >= 2 && dash[-1] == '-' && dash[-2] == '-');
+                }
+                if(!found){
+                    tokenizer->at = tokenizer->final ? data.size : start;
+                    return(false);
+                }
+                after = at;
+            }
+            tokenizer->at = after;
+            continue;
+        }
+
+        *token = {};
+        if(tag.size && tag.str[0] == '/'){
+            str8_advance(&tag, 1);
+            token->type = OFXTokenType_Close;
+            token->name = ofx_trim(tag);
+            tokenizer->at = after;
+            return(true);
+        }
+
+        // note: the value runs up to the next tag, which has to be in the window to know the value is whole
+        u8* next = ofx_find(tokenizer, after, '<');
+        u64 value_end = next ? (u64)(next - data.str) : data.size;
+        if(!next && !tokenizer->final){
+            tokenizer->at = start;
+            return(false);
+        }
+
+        // note: drop attributes and the / of a self closing tag
+        tag = ofx_trim(tag);
+        if(tag.size && tag.str[tag.size - 1] == '/'){
+            --tag.size;
+        }
+        for(u64 i=0; i < tag.size; ++i){
+            if(tag.str[i] == ' ' || tag.str[i] == '\t' || tag.str[i] == '\r' || tag.str[i] == '\n'){
+                tag.size = i;
+                break;
+            }
+        }
+
+        token->type = OFXTokenType_Open;
+        token->name = tag;
+        token->value = ofx_trim(str8(data.str + after, value_end - after));
+        tokenizer->at = value_end;
+        return(true);
+    }
+}
+
+// note: copies a value decoding the entities SGML and XML OFX both use, clamped like csv_copy_field()
+static void
+ofx_copy_value(char* dst, u32 capacity, String8 value){
+    u32 size = 0;
+    for(u64 i=0; i < value.size && size + 4 < capacity;){
+        u8 c = value.str[i];
+        if(c != '&'){
+            dst[size++] = c;
+            ++i;
+            continue;
+        }
+
+        String8 rest = str8(value.str + i, value.size - i);
+        if(str8_starts_with(rest, str8_literal("&amp;"))){ dst[size++] = '&'; i += 5; }
+        else if(str8_starts_with(rest, str8_literal("&lt;"))){ dst[size++] = '<'; i += 4; }
+        else if(str8_starts_with(rest, str8_literal("&gt;"))){ dst[size++] = '>'; i += 4; }
+        else if(str8_starts_with(rest, str8_literal("&quot;"))){ dst[size++] = '"'; i += 6; }
+        else if(str8_starts_with(rest, str8_literal("&apos;"))){ dst[size++] = '\''; i += 6; }
+        else if(str8_starts_with(rest, str8_literal("&#"))){
+            u32 codepoint = 0;
+            u64 at = i + 2;
+            bool hex = (at < value.size && (value.str[at] == 'x' || value.str[at] == 'X'));
+            at += hex;
+            for(; at < value.size && value.str[at] != ';'; ++at){
+                u8 d = value.str[at];
+                u32 digit = (d >= '0' && d <= '9') ? d - '0' : (hex && (d | 0x20) >= 'a' && (d | 0x20) <= 'f') ? (d | 0x20) - 'a' + 10 : 0xFF;
+                if(digit == 0xFF || codepoint > 0x10FFFF){
+                    break;
+                }
+                codepoint = codepoint * (hex ? 16 : 10) + digit;
+            }
+            if(at < value.size && value.str[at] == ';' && codepoint && codepoint <= 0x10FFFF){
+                size += (u32)csv_utf8_encode(codepoint, (u8*)dst + size);
+                i = at + 1;
+            }
+            else{
+                dst[size++] = c;
+                ++i;
+            }
+        }
+        else{
+            dst[size++] = c;
+            ++i;
+        }
+    }
+
+    // note: don't leave half a utf-8 sequence at the end
+    u32 end = size;
+    while(end && ((u8)dst[end - 1] & 0xC0) == 0x80){
+        --end;
+    }
+    if(end && (u8)dst[end - 1] >= 0xC0){
+        u8 lead = (u8)dst[end - 1];
+        u32 length = (lead >= 0xF0) ? 4 : (lead >= 0xE0) ? 3 : 2;
+        if(end - 1 + length > size){
+            size = end - 1;
+        }
+    }
+    dst[size] = '\0';
+}
+
+// note: YYYYMMDD with an optional time and zone after it, which are ignored
+static u32
+ofx_parse_date(String8 value){
+    if(value.size < 8){
+        return(0);
+    }
+    u32 parts[3] = {0};
+    u32 widths[3] = {4, 2, 2};
+    u64 at = 0;
+    for(u32 part=0; part < 3; ++part){
+        for(u32 i=0; i < widths[part]; ++i, ++at){
+            u8 c = value.str[at];
+            if(c < '0' || c > '9'){
+                return(0);
+            }
+            parts[part] = parts[part] * 10 + (c - '0');
+        }
+    }
+    if(parts[1] < 1 || parts[1] > 12 || parts[2] < 1 || parts[2] > 31){
+        return(0);
+    }
+
+    u32 result = date_key(parts[0], parts[1], parts[2]);
+    return(result);
+}
+
+// note: SGML OFX says its charset in the header instead of a BOM, CHARSET:1252 isn't always caught by sampling
+static CSVEncoding
+ofx_header_encoding(String8 data, CSVEncoding detected){
+    if(detected != CSVEncoding_UTF8){
+        return(detected);
+    }
+    u8* first_tag = (u8*)memchr(data.str, '<', data.size);
+    String8 header = {data.str, first_tag ? (u64)(first_tag - data.str) : data.size};
+    for(u64 i=0; i + 12 <= header.size; ++i){
+        if(str8_starts_with(str8(header.str + i, header.size - i), str8_literal("CHARSET:1252"))){
+            return(CSVEncoding_Windows1252);
+        }
+    }
+    return(detected);
+}
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef OFX_H
+#define OFX_H
+
+// note: SAX style tokens of an OFX file, both SGML (1.x) and XML (2.x). Leaf elements come back as an Open
+// token with their text in value, SGML leaves have no closing tag and XML leaf closes can be ignored, so
+// the same handling works for both. Aggregates are an Open with no value and a Close.
+typedef enum OFXTokenType{
+    OFXTokenType_None,
+    OFXTokenType_Open,
+    OFXTokenType_Close,
+    OFXTokenType_Count,
+} OFXTokenType;
+
+typedef struct OFXToken{
+    OFXTokenType type;
+    String8 name;
+    String8 value; // note: trimmed, still has its entities (&amp;), see ofx_copy_value()
+} OFXToken;
+
+// note: Walks a window of the file. A token is only handed out once the '<' after it is in the window (or
+// the window is final), so at is always where the next window has to start when tokens run out.
+typedef struct OFXTokenizer{
+    String8 data;
+    u64 at;
+    bool final;
+} OFXTokenizer;
+
+static OFXTokenizer ofx_tokenizer(String8 data, bool final);
+static bool         ofx_next_token(OFXTokenizer* tokenizer, OFXToken* token);
+static void         ofx_copy_value(char* dst, u32 capacity, String8 value);
+static u32          ofx_parse_date(String8 value);
+static CSVEncoding  ofx_header_encoding(String8 data, CSVEncoding detected);
+
+#endif
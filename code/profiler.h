@@ -1,3 +1,8 @@
+#if !defined(_WIN32)
+#include <time.h>
+#include <x86intrin.h>
+#endif
+
 #ifndef PROFILER_TIMER
 #define PROFILER_TIMER __rdtsc()
 #endif
@@ -23,7 +28,7 @@ struct ProfileAnchor{
     String8 label;
 };
 static ProfileAnchor profile_anchors[4096];
-static u32 parent_anchor_index;
+static thread_local u32 parent_anchor_index; // note: per thread, imports are profiled on their worker threads
 
 struct ProfileBlock{
     String8 label;
@@ -103,25 +108,45 @@ print_anchor_data(u64 total_cpu_elapsed, u64 cpu_freq){
 
 #endif
 
+// note: the OS timer the cpu frequency is measured against, QPC on windows and the monotonic clock in ns elsewhere
+static u64
+profiler_os_frequency(void){
+#if defined(_WIN32)
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    return((u64)frequency.QuadPart);
+#else
+    return(1000000000);
+#endif
+}
+
+static u64
+profiler_os_timer(void){
+#if defined(_WIN32)
+    LARGE_INTEGER QPC;
+    QueryPerformanceCounter(&QPC);
+    return((u64)QPC.QuadPart);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return((u64)now.tv_sec * 1000000000 + (u64)now.tv_nsec);
+#endif
+}
+
 static u64
 estimate_cpu_frequency(void){
 	u64 ms_to_wait = 100;
 
-    LARGE_INTEGER frequency;
-    QueryPerformanceFrequency(&frequency);
-	u64 os_freq = (u64)frequency.QuadPart;
+	u64 os_freq = profiler_os_frequency();
 
 	u64 cpu_start = PROFILER_TIMER;
 
-    LARGE_INTEGER QPC;
-    QueryPerformanceCounter(&QPC);
-	u64 os_start = (u64)QPC.QuadPart;
+	u64 os_start = profiler_os_timer();
 	u64 os_end = 0;
 	u64 os_elapsed = 0;
 	u64 os_wait_time = os_freq * ms_to_wait / 1000;
 	while(os_elapsed < os_wait_time){
-        QueryPerformanceCounter(&QPC);
-        os_end = (u64)QPC.QuadPart;
+        os_end = profiler_os_timer();
 		os_elapsed = os_end - os_start;
 	}
 
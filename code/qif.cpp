@@ -0,0 +1,92 @@
+#ifndef QIF_C
+#define QIF_C
+
+static QIFLines
+qif_lines(String8 data, bool final){
+    QIFLines result = {0};
+    result.data = data;
+    result.final = final;
+    return(result);
+}
+
+static bool
+qif_next_line(QIFLines* lines, String8* line){
+    String8 data = lines->data;
+    if(lines->at >= data.size){
+        return(false);
+    }
+
+    u8* start = data.str + lines->at;
+    u8* newline = (u8*)memchr(start, '\n', data.size - lines->at);
+    if(!newline && !lines->final){
+        return(false);
+    }
+
+    u8* end = newline ? newline : data.str + data.size;
+    lines->at = (end - data.str) + (newline ? 1 : 0);
+
+    *line = str8(start, end - start);
+    while(line->size && (line->str[line->size - 1] == '\r' || line->str[line->size - 1] == ' ' || line->str[line->size - 1] == '\t')){
+        --line->size;
+    }
+    return(true);
+}
+
+// note: !Option: and !Clear: lines are switches inside a block, they don't start one
+static QIFBlock
+qif_block(String8 line, QIFBlock current){
+    if(str8_starts_with(line, str8_literal("!Option:")) || str8_starts_with(line, str8_literal("!Clear:"))){
+        return(current);
+    }
+    if(str8_compare_nocase(line, str8_literal("!Account"))){
+        return(QIFBlock_Account);
+    }
+
+    String8 prefix = str8_literal("!Type:");
+    if(line.size < prefix.size || !str8_compare_nocase(str8(line.str, prefix.size), prefix)){
+        return(QIFBlock_None);
+    }
+    String8 type = str8(line.str + prefix.size, line.size - prefix.size);
+    str8_eat_spaces(&type);
+    if(str8_compare_nocase(type, str8_literal("Bank")) || str8_compare_nocase(type, str8_literal("Cash")) ||
+       str8_compare_nocase(type, str8_literal("CCard")) || str8_compare_nocase(type, str8_literal("Oth A")) ||
+       str8_compare_nocase(type, str8_literal("Oth L"))){
+        return(QIFBlock_Transactions);
+    }
+    return(QIFBlock_None);
+}
+
+// note: Quicken writes M/D/YY with an apostrophe before the year from 2000 on (1/ 5'04), other tools write
+// M/D/YYYY or Y-M-D. Spaces pad single digits. A 2 digit year without the apostrophe is 19YY from 70 up.
+static u32
+qif_parse_date(String8 value){
+    u8 buffer[32];
+    u32 size = 0;
+    bool apostrophe = false;
+    for(u64 i=0; i < value.size && size < array_count(buffer); ++i){
+        u8 c = value.str[i];
+        if(c == '\''){
+            apostrophe = true;
+            c = '/';
+        }
+        if(c != ' '){
+            buffer[size++] = c;
+        }
+    }
+
+    u32 result = csv_parse_date(str8(buffer, size), false);
+    u32 first_digits = 0;
+    while(first_digits < size && buffer[first_digits] >= '0' && buffer[first_digits] <= '9'){
+        ++first_digits;
+    }
+    u32 year_digits = 0;
+    while(year_digits < size && buffer[size - year_digits - 1] >= '0' && buffer[size - year_digits - 1] <= '9'){
+        ++year_digits;
+    }
+    if(result && first_digits <= 2 && year_digits == 2 && !apostrophe && (result >> 9) >= 2070){
+        result -= (100 << 9);
+    }
+    return(result);
+}
+
+#endif
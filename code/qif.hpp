@@ -0,0 +1,26 @@
+#ifndef QIF_H
+#define QIF_H
+
+// note: QIF is one field per line, the first character says which field (D date, T amount, P payee,
+// L category, M memo), ^ ends a record and !Type: lines start a block of records of one kind.
+typedef enum QIFBlock{
+    QIFBlock_None,         // note: categories, classes, memorized and investment blocks, skipped
+    QIFBlock_Transactions, // note: Bank, Cash, CCard, Oth A, Oth L
+    QIFBlock_Account,      // note: !Account, records name the account the following blocks belong to
+    QIFBlock_Count,
+} QIFBlock;
+
+// note: Walks a window of the file one line at a time. A line is only handed out once its newline is in
+// the window (or the window is final), so at is always where the next window has to start.
+typedef struct QIFLines{
+    String8 data;
+    u64 at;
+    bool final;
+} QIFLines;
+
+static QIFLines qif_lines(String8 data, bool final);
+static bool     qif_next_line(QIFLines* lines, String8* line);
+static QIFBlock qif_block(String8 line, QIFBlock current);
+static u32      qif_parse_date(String8 value);
+
+#endif
@@ -0,0 +1,10 @@
+@echo off
+
+rem note: builds the standalone csv parser benchmark (code\csv_bench.cpp) with optimizations on
+set cl_includes=-I ..\..\base\code
+set cl_flags=/Zi /nologo -std:c++latest -O2 -DRELEASE=1
+
+IF NOT EXIST ..\build mkdir ..\build
+pushd ..\build
+cl /EHsc %cl_flags% %cl_includes% ..\code\csv_bench.cpp /Fecsv_bench.exe
+popd
@@ -0,0 +1,9 @@
+#!/bin/sh
+
+# note: builds the standalone csv benchmark (code/csv_bench.cpp) with optimizations on, linux side of build_bench.bat
+cd "$(dirname "$0")"
+includes="-I ../../base/code"
+flags="-std=c++20 -g -O2 -DRELEASE=1 -Wno-write-strings"
+
+mkdir -p ../build
+${CXX:-g++} $flags $includes ../code/csv_bench.cpp -o ../build/csv_bench -lpthread